@@ -0,0 +1,361 @@
+#ifndef CONCURRENT_DICTIONARY
+#define CONCURRENT_DICTIONARY
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Epoch based reclamation shared by every Concurrent_Dictionary.
+// A reader publishes the global epoch in its own slot while it looks at shared nodes. A writer that
+// unlinks a node tags it with the epoch it bumped the counter from and frees it only once no reader
+// still publishes an epoch that old, so readers never take a lock and never see freed memory.
+// The first SLOTS reading threads get a slot each; any further ones share one overflow slot that
+// holds the oldest epoch of its readers, which holds back reclamation a little longer but never fails.
+class Epoch_Manager
+{
+	static const int SLOTS = 256;	// threads with a slot of their own
+	static const int READER_BITS = 16;	// low bits of shared count its readers, the rest is their epoch
+
+	struct alignas(64) Slot
+	{
+		std::atomic<uint64_t> epoch;	// 0 while the owner is not reading
+		std::atomic<bool> owned;
+	};
+
+	// claims a slot for the calling thread and gives it back when the thread ends;
+	// nullptr when all are taken, the thread then reads through the shared slot
+	struct Slot_Owner
+	{
+		Slot* slot;
+		explicit Slot_Owner(Epoch_Manager& m) : slot(nullptr) {
+			for (int i = 0; i < SLOTS && !slot; i++) {
+				bool expected = false;
+				if (m.slots[i].owned.compare_exchange_strong(expected, true))
+					slot = &m.slots[i];
+			}
+		}
+		~Slot_Owner() {
+			if (!slot)
+				return;
+			slot->epoch.store(0);
+			slot->owned.store(false);
+		}
+	};
+
+	Slot slots[SLOTS];
+	alignas(64) std::atomic<uint64_t> shared;	// epoch << READER_BITS | readers, 0 while nobody reads
+	alignas(64) std::atomic<uint64_t> global;
+
+	// a reader joining others keeps their older epoch, which still covers everything it can reach
+	void enterShared() {
+		uint64_t cur = shared.load();
+		for (;;) {
+			uint64_t readers = cur & ((uint64_t(1) << READER_BITS) - 1);
+			if (readers + 1 == uint64_t(1) << READER_BITS)
+				throw std::runtime_error("too many threads reading concurrent dictionaries");
+			uint64_t next = readers ? cur + 1 : global.load() << READER_BITS | 1;
+			if (shared.compare_exchange_weak(cur, next))
+				return;
+		}
+	}
+
+	void leaveShared() {
+		uint64_t cur = shared.load();
+		for (;;) {
+			uint64_t next = (cur & ((uint64_t(1) << READER_BITS) - 1)) == 1 ? 0 : cur - 1;
+			if (shared.compare_exchange_weak(cur, next))
+				return;
+		}
+	}
+
+	Epoch_Manager() : shared(0), global(1) {
+		for (int i = 0; i < SLOTS; i++) {
+			slots[i].epoch.store(0);
+			slots[i].owned.store(false);
+		}
+	}
+
+public:
+	static Epoch_Manager& instance() {
+		static Epoch_Manager manager;
+		return manager;
+	}
+
+	// the calling thread's own slot, nullptr if it reads through the shared one
+	Slot* mySlot() {
+		thread_local Slot_Owner owner(*this);
+		return owner.slot;
+	}
+
+	// keeps every node reachable when it is constructed alive until it is destroyed
+	class Guard {
+	private:
+		Slot* slot;
+		bool outer;	// nested guards leave an own slot to the outermost one
+	public:
+		Guard() : slot(Epoch_Manager::instance().mySlot()), outer(!slot || slot->epoch.load(std::memory_order_relaxed) == 0) {
+			if (!slot)
+				Epoch_Manager::instance().enterShared();
+			else if (outer)
+				slot->epoch.store(Epoch_Manager::instance().global.load());
+			std::atomic_thread_fence(std::memory_order_seq_cst);	// publish before touching any node
+		}
+		~Guard() {
+			if (!slot)
+				Epoch_Manager::instance().leaveShared();
+			else if (outer)
+				slot->epoch.store(0, std::memory_order_release);
+		}
+		Guard(const Guard&) = delete;
+		Guard& operator=(const Guard&) = delete;
+	};
+
+	// tag for something that was just unlinked
+	uint64_t retireEpoch() {
+		return global.fetch_add(1);
+	}
+
+	// everything retired with a tag below this can be freed
+	uint64_t safeEpoch() const {
+		uint64_t safe = UINT64_MAX;
+		for (int i = 0; i < SLOTS; i++) {
+			uint64_t e = slots[i].epoch.load();
+			if (e != 0 && e < safe)
+				safe = e;
+		}
+		uint64_t e = shared.load() >> READER_BITS;
+		if (e != 0 && e < safe)
+			safe = e;
+		return safe;
+	}
+};
+
+// Hash dictionary for many threads. Keys are spread over Shards independent chained hash tables,
+// each with its own writer mutex, so writers only contend within a shard. Readers (find, get)
+// take no lock at all: nodes are immutable once published, a write links a new node and retires
+// the old one through Epoch_Manager, and a growing shard publishes a fresh copy of its table.
+// get() returns a copy of the value, since a reference could outlive the node.
+template<typename key, typename val, int Shards = 64, typename Hash = std::hash<key>>
+class Concurrent_Dictionary
+{
+	struct Node
+	{
+		const key _key;
+		const val _val;
+		std::atomic<Node*> next;
+		template<typename K, typename V>
+		Node(K&& _k, V&& _v, Node* _next) : _key(std::forward<K>(_k)), _val(std::forward<V>(_v)), next(_next) {}
+	};
+
+	struct Table
+	{
+		size_t mask;
+		std::atomic<Node*>* buckets;
+		explicit Table(size_t count) : mask(count - 1), buckets(new std::atomic<Node*>[count]) {
+			for (size_t i = 0; i < count; i++)
+				buckets[i].store(nullptr, std::memory_order_relaxed);
+		}
+		~Table() { delete[] buckets; }
+	};
+
+	struct Retired
+	{
+		uint64_t epoch;
+		Node* node;	// either a node
+		Table* table;	// or a whole table whose nodes were copied elsewhere
+	};
+
+	// aligned so that neighbouring shards never share a cache line
+	struct alignas(64) Shard
+	{
+		std::atomic<Table*> table;
+		std::mutex writer;
+		int size;	// guarded by writer
+		std::vector<Retired> retired;	// guarded by writer
+	};
+
+	static const size_t INITIAL_BUCKETS = 16;
+	static const size_t RECLAIM_BATCH = 64;
+
+	Shard shards[Shards];
+	std::atomic<int> size;
+	Hash hasher;
+
+	static uint64_t mix(size_t h) {
+		uint64_t x = static_cast<uint64_t>(h) * 0x9E3779B97F4A7C15ull;
+		return x ^ (x >> 29);
+	}
+
+	Shard& shardOf(uint64_t h) { return shards[(h >> 48) % Shards]; }
+	const Shard& shardOf(uint64_t h) const { return shards[(h >> 48) % Shards]; }
+
+	static void freeChain(Node* n) {
+		while (n) {
+			Node* next = n->next.load(std::memory_order_relaxed);
+			delete n;
+			n = next;
+		}
+	}
+
+	static void freeTable(Table* t, bool withNodes) {
+		if (withNodes)
+			for (size_t i = 0; i <= t->mask; i++)
+				freeChain(t->buckets[i].load(std::memory_order_relaxed));
+		delete t;
+	}
+
+	// caller holds shard.writer
+	void retire(Shard& shard, Node* node, Table* table) {
+		shard.retired.push_back(Retired{ Epoch_Manager::instance().retireEpoch(), node, table });
+		if (shard.retired.size() < RECLAIM_BATCH)
+			return;
+		uint64_t safe = Epoch_Manager::instance().safeEpoch();
+		size_t kept = 0;
+		for (size_t i = 0; i < shard.retired.size(); i++) {
+			Retired& r = shard.retired[i];
+			if (r.epoch < safe) {
+				if (r.node)
+					delete r.node;
+				else
+					freeTable(r.table, true);
+			}
+			else
+				shard.retired[kept++] = r;
+		}
+		shard.retired.resize(kept);
+	}
+
+	// doubles the buckets once a shard averages two entries per bucket; caller holds shard.writer.
+	// Readers may still walk the old chains, so the nodes are copied and the old table retired whole
+	void grow(Shard& shard) {
+		Table* old = shard.table.load(std::memory_order_relaxed);
+		if (static_cast<size_t>(shard.size) <= 2 * (old->mask + 1))
+			return;
+		Table* bigger = new Table(2 * (old->mask + 1));
+		for (size_t i = 0; i <= old->mask; i++) {
+			for (Node* n = old->buckets[i].load(std::memory_order_relaxed); n; n = n->next.load(std::memory_order_relaxed)) {
+				std::atomic<Node*>& bucket = bigger->buckets[mix(hasher(n->_key)) & bigger->mask];
+				bucket.store(new Node(n->_key, n->_val, bucket.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+			}
+		}
+		shard.table.store(bigger, std::memory_order_release);
+		retire(shard, nullptr, old);
+	}
+
+	// link slot holding _key in its bucket, or nullptr; caller holds shard.writer
+	std::atomic<Node*>* findLink(Table* t, uint64_t h, const key& _key) {
+		std::atomic<Node*>* link = &t->buckets[h & t->mask];
+		for (Node* n = link->load(std::memory_order_relaxed); n; n = link->load(std::memory_order_relaxed)) {
+			if (n->_key == _key)
+				return link;
+			link = &n->next;
+		}
+		return nullptr;
+	}
+
+	template<typename K, typename V>
+	bool put(K&& _key, V&& _val, bool overwrite) {
+		uint64_t h = mix(hasher(_key));
+		Shard& shard = shardOf(h);
+		std::lock_guard<std::mutex> lock(shard.writer);
+		Table* t = shard.table.load(std::memory_order_relaxed);
+		std::atomic<Node*>* link = findLink(t, h, _key);
+		if (link) {
+			if (!overwrite)
+				return false;
+			Node* old = link->load(std::memory_order_relaxed);
+			Node* replacement = new Node(std::forward<K>(_key), std::forward<V>(_val), old->next.load(std::memory_order_relaxed));
+			link->store(replacement, std::memory_order_release);
+			retire(shard, old, nullptr);
+			return true;
+		}
+		std::atomic<Node*>& bucket = t->buckets[h & t->mask];
+		bucket.store(new Node(std::forward<K>(_key), std::forward<V>(_val), bucket.load(std::memory_order_relaxed)), std::memory_order_release);
+		shard.size++;
+		size.fetch_add(1, std::memory_order_relaxed);
+		grow(shard);
+		return true;
+	}
+
+	const Node* lookup(const key& _key) const {
+		uint64_t h = mix(hasher(_key));
+		const Table* t = shardOf(h).table.load(std::memory_order_acquire);
+		for (const Node* n = t->buckets[h & t->mask].load(std::memory_order_acquire); n; n = n->next.load(std::memory_order_acquire))
+			if (n->_key == _key)
+				return n;
+		return nullptr;
+	}
+
+public:
+	Concurrent_Dictionary() : size(0) {
+		for (int i = 0; i < Shards; i++) {
+			shards[i].table.store(new Table(INITIAL_BUCKETS));
+			shards[i].size = 0;
+		}
+	}
+
+	// no other thread may use the dictionary any more
+	~Concurrent_Dictionary() {
+		for (int i = 0; i < Shards; i++) {
+			freeTable(shards[i].table.load(), true);
+			for (Retired& r : shards[i].retired) {
+				if (r.node)
+					delete r.node;
+				else
+					freeTable(r.table, true);
+			}
+		}
+	}
+
+	Concurrent_Dictionary(const Concurrent_Dictionary&) = delete;
+	Concurrent_Dictionary& operator= (const Concurrent_Dictionary&) = delete;
+
+	int getSize() const { return size.load(std::memory_order_relaxed); }
+
+	// like Dictionary::insert: an existing key keeps its value; returns whether it was inserted
+	bool insert(key _key, val _val) {
+		return put(std::move(_key), std::move(_val), false);
+	}
+
+	// inserts or replaces the value
+	void assign(key _key, val _val) {
+		put(std::move(_key), std::move(_val), true);
+	}
+
+	bool erase(const key& _key) {
+		uint64_t h = mix(hasher(_key));
+		Shard& shard = shardOf(h);
+		std::lock_guard<std::mutex> lock(shard.writer);
+		std::atomic<Node*>* link = findLink(shard.table.load(std::memory_order_relaxed), h, _key);
+		if (!link)
+			return false;
+		Node* old = link->load(std::memory_order_relaxed);
+		link->store(old->next.load(std::memory_order_relaxed), std::memory_order_release);
+		shard.size--;
+		size.fetch_sub(1, std::memory_order_relaxed);
+		retire(shard, old, nullptr);
+		return true;
+	}
+
+	// lock free
+	bool find(const key& _key) const {
+		Epoch_Manager::Guard guard;
+		return lookup(_key) != nullptr;
+	}
+
+	// lock free; copies the value into out
+	bool get(const key& _key, val& out) const {
+		Epoch_Manager::Guard guard;
+		const Node* n = lookup(_key);
+		if (!n)
+			return false;
+		out = n->_val;
+		return true;
+	}
+};
+
+#endif
@@ -2,13 +2,35 @@
 #define DICTIONARY
 
 #include "Linked_List.h"
-#include <map>
+#include "Flat_List.h"
+#include "Hash_Table.h"
+#include "Skip_List.h"
+#include "Unrolled_List.h"
+#include <functional>
+#include <queue>
+#include <type_traits>
+#include <vector>
 
-template<typename key, typename val>
+// integral keys default to the contiguous, SIMD searched Flat_List, all other keys to Linked_List.
+// With Flat_List any insert moves the entries: references from operator[] and pointers from get()
+// and find_many() dangle, iterators are invalidated, and a single insert shifts the arrays, O(n).
+// Pass Linked_List<key, val> as storage to keep the old stable references.
+// Stats is passed on to the storage, e.g. Dictionary<key, val, default_storage<key, val, counting_stats>::type>
+template<typename key, typename val, typename Stats = no_stats>
+struct default_storage
+{
+	typedef typename std::conditional<std::is_integral<key>::value && !std::is_same<key, bool>::value,
+		Flat_List<key, val, Stats>, Linked_List<key, val, Stats>>::type type;
+};
+
+// storage can be any container with the Linked_List interface, e.g. Skip_List<key, val> for O(log n)
+// sorted inserts, Unrolled_List<key, val> for cache friendly scans, Hash_Table<key, val> for O(1) lookups
+// or Hash_Table<key, val, true> to also iterate in key order
+template<typename key, typename val, typename storage = typename default_storage<key, val>::type>
 class Dictionary
 {
 private:
-	Linked_List<key, val> llist;
+	storage llist;
 
 public:
 	//constructors/destructor
@@ -18,32 +40,38 @@ public:
 	Dictionary(const Dictionary& newList) {
 		this->llist = newList.llist;
 	}
-	Dictionary<key, val>& operator= (const Dictionary& newDict) {
+	Dictionary& operator= (const Dictionary& newDict) {
 		this->llist = newDict.llist;
 		return *this;
 	}
+	Dictionary(Dictionary&& newDict) noexcept : llist(std::move(newDict.llist)) {
+
+	}
+	Dictionary& operator= (Dictionary&& newDict) noexcept {
+		this->llist = std::move(newDict.llist);
+		return *this;
+	}
 	~Dictionary() {
 		llist.clear();
 	}
 	//Iterator
-	typename Linked_List<key, val>::Iterator begin() { return llist.begin(); }
-	typename Linked_List<key, val>::Iterator end() { return llist.end(); }
+	typename storage::Iterator begin() { return llist.begin(); }
+	typename storage::Iterator end() { return llist.end(); }
 
 	//const Iterator
-	typename Linked_List<key, val>::Const_Iterator constBegin() const { return llist.constBegin(); }
-	typename Linked_List<key, val>::Const_Iterator constEnd() const { return llist.constEnd(); }
+	typename storage::Const_Iterator constBegin() const { return llist.constBegin(); }
+	typename storage::Const_Iterator constEnd() const { return llist.constEnd(); }
 
 	val& operator[] (const key& _key) {
-		auto it = llist.begin();
-		while (it != llist.end()) {
-			if (it.getKey() == _key)
-				return it.getValRef();
-			++it;
-		}
-
-		throw "key not found";
+		val* found = llist.get(_key);
+		if (!found)
+			throw "key not found";
+		return *found;
 	}
 
+	// pointer to the value of a key, nullptr when it is missing
+	val* get(const key& _key) { return llist.get(_key); }
+
 	//Methods
 	int getSize() { return llist.getSize(); }
 	void print() { llist.print(); }
@@ -52,30 +80,139 @@ public:
 		if (llist.find(_key)) {	// if we already have such element we don't change anything	
 			return;
 		}
-		llist.insert(_key, _val);
+		llist.insert(std::move(_key), std::move(_val));
+	}
+
+	// inserts a range of (key, val) pairs in one pass over the storage; like insert,
+	// keys that are already present keep their value
+	template<typename It>
+	void insert_batch(It first, It last) {
+		llist.insert_batch(first, last, true);
+	}
+
+	// value pointer (nullptr when missing) for every key of a range, in input order
+	template<typename It>
+	std::vector<val*> find_many(It first, It last) {
+		return llist.find_many(first, last);
+	}
+
+	// counters of the storage's instrumentation policy (all zero with no_stats)
+	container_stats stats() const { return llist.stats(); }
+	void reset_stats() { llist.reset_stats(); }
+
+	// adds an entry whose key is greater than every key already present, O(1)
+	void append(key _key, val _val) {
+		llist.push_back(std::move(_key), std::move(_val));
 	}
 };
 
-template<typename key, typename val>
-Dictionary<key, val> join(const Dictionary<key, val>& l1, const Dictionary<key, val>& l2)
+// merges two dictionaries; values of keys present in both are combined with combine(v1, v2).
+// Ordered storages are merged in one pass over both inputs, appending to the result, O(n + m);
+// unordered ones start from a copy of l1 and look every key of l2 up in it
+template<typename key, typename val, typename storage, typename Combine = std::plus<val>>
+Dictionary<key, val, storage> join(const Dictionary<key, val, storage>& l1, const Dictionary<key, val, storage>& l2, Combine combine = Combine())
 {
-	Dictionary<key, val> ans;
+	if (!storage::ordered) {
+		Dictionary<key, val, storage> ans = l1;
+		for (auto it = l2.constBegin(); it != l2.constEnd(); ++it) {
+			val* found = ans.get(it.getKey());
+			if (found)
+				*found = combine(*found, it.getVal());
+			else
+				ans.insert(it.getKey(), it.getVal());
+		}
+		return ans;
+	}
+
+	Dictionary<key, val, storage> ans;
 	auto it1 = l1.constBegin();
 	auto it2 = l2.constBegin();
 
-	std::map<key, val> hashMap;
-	for (it1; it1 != l1.constEnd(); it1++) {
-		hashMap[it1.getKey()] += it1.getVal();
+	while (it1 != l1.constEnd() && it2 != l2.constEnd()) {
+		if (it1.getKey() < it2.getKey()) {
+			ans.append(it1.getKey(), it1.getVal());
+			++it1;
+		}
+		else if (it2.getKey() < it1.getKey()) {
+			ans.append(it2.getKey(), it2.getVal());
+			++it2;
+		}
+		else {
+			ans.append(it1.getKey(), combine(it1.getVal(), it2.getVal()));
+			++it1;
+			++it2;
+		}
+	}
+
+	for (; it1 != l1.constEnd(); ++it1) {
+		ans.append(it1.getKey(), it1.getVal());
+	}
+
+	for (; it2 != l2.constEnd(); ++it2) {
+		ans.append(it2.getKey(), it2.getVal());
+	}
+
+	return ans;
+}
+
+// k-way join: a min-heap holds the current entry of every input, so ordered storages
+// are merged in O(N log k) for N entries in total
+template<typename key, typename val, typename storage, typename Combine = std::plus<val>>
+Dictionary<key, val, storage> join(const std::vector<Dictionary<key, val, storage>>& dicts, Combine combine = Combine())
+{
+	Dictionary<key, val, storage> ans;
+
+	if (!storage::ordered) {
+		for (const auto& d : dicts) {
+			for (auto it = d.constBegin(); it != d.constEnd(); ++it) {
+				val* found = ans.get(it.getKey());
+				if (found)
+					*found = combine(*found, it.getVal());
+				else
+					ans.insert(it.getKey(), it.getVal());
+			}
+		}
+		return ans;
 	}
 
-	for (it2; it2 != l2.constEnd(); it2++) {
-		hashMap[it2.getKey()] += it2.getVal();
+	typedef typename storage::Const_Iterator Const_Iterator;
+	struct Cursor {
+		Const_Iterator it;
+		Const_Iterator end;
+		size_t index;	// ties are combined in input order
+	};
+	auto later = [](const Cursor& a, const Cursor& b) {
+		if (a.it.getKey() < b.it.getKey())
+			return false;
+		if (b.it.getKey() < a.it.getKey())
+			return true;
+		return a.index > b.index;
+	};
+	std::priority_queue<Cursor, std::vector<Cursor>, decltype(later)> heap(later);
+
+	for (size_t i = 0; i < dicts.size(); i++) {
+		if (dicts[i].constBegin() != dicts[i].constEnd())
+			heap.push(Cursor{ dicts[i].constBegin(), dicts[i].constEnd(), i });
 	}
 
-	for (const auto& i : hashMap) {
-		ans.insert(i.first, i.second);
+	while (!heap.empty()) {
+		Cursor top = heap.top();
+		heap.pop();
+		key _key = top.it.getKey();
+		val _val = top.it.getVal();
+		for (;;) {
+			++top.it;
+			if (top.it != top.end)
+				heap.push(top);
+			if (heap.empty() || !(heap.top().it.getKey() == _key))
+				break;
+			top = heap.top();
+			heap.pop();
+			_val = combine(_val, top.it.getVal());
+		}
+		ans.append(std::move(_key), std::move(_val));
 	}
 
 	return ans;
 }
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,301 @@
+#ifndef FLAT_LIST
+#define FLAT_LIST
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "container_stats.h"
+#if defined(__AVX2__)
+#define FLAT_LIST_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FLAT_LIST_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Sorted list with the Linked_List interface for trivially copyable integral keys. Keys sit in one
+// contiguous array and values in a parallel one, so a lookup narrows the range by binary search and
+// finishes with a SIMD scan of the last few keys: 8 int32 (or 4 int64) per AVX2 compare, half that
+// with SSE2, one at a time for other key widths. Inserts shift the arrays, which for integer keys is a
+// memmove and still far cheaper than walking nodes. Dictionary picks it for integral keys.
+// Unlike Linked_List, whose nodes never move, every insert or erase invalidates iterators and the
+// pointers returned by get() and find_many(), and a single insert is O(n) because of the shift.
+// Stats is an instrumentation policy from container_stats.h; allocations count array growths.
+template<typename key, typename val, typename Stats = no_stats>
+class Flat_List : private Stats
+{
+	static_assert(std::is_integral<key>::value && !std::is_same<key, bool>::value, "Flat_List needs integral keys");
+
+	// wrapper so that val = bool does not select std::vector<bool>; an aggregate, built as Value{ v }
+	struct Value
+	{
+		val _val;
+	};
+
+	static const size_t npos = static_cast<size_t>(-1);
+	static const size_t SCAN = 32;	// ranges this short are scanned instead of halved further
+
+	std::vector<key> keys;
+	std::vector<Value> vals;
+
+	static unsigned lowestBit(uint32_t bits) {
+#if defined(_MSC_VER)
+		unsigned long i;
+		_BitScanForward(&i, bits);
+		return i;
+#else
+		return __builtin_ctz(bits);
+#endif
+	}
+
+	// index of the first key equal to _key in p[0, count), or npos
+	static size_t scan(const key* p, size_t count, key _key, std::false_type) {
+		for (size_t i = 0; i < count; i++)
+			if (p[i] == _key)
+				return i;
+		return npos;
+	}
+
+	static size_t scan(const key* p, size_t count, key _key, std::true_type) {
+		size_t i = 0;
+#if defined(FLAT_LIST_AVX2)
+		const __m256i needle = sizeof(key) == 4 ? _mm256_set1_epi32(static_cast<int32_t>(_key)) : _mm256_set1_epi64x(static_cast<int64_t>(_key));
+		for (; i + 32 / sizeof(key) <= count; i += 32 / sizeof(key)) {
+			__m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+			__m256i eq = sizeof(key) == 4 ? _mm256_cmpeq_epi32(block, needle) : _mm256_cmpeq_epi64(block, needle);
+			uint32_t bits = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+			if (bits)
+				return i + lowestBit(bits) / sizeof(key);
+		}
+#elif defined(FLAT_LIST_SSE2)
+		const __m128i needle = sizeof(key) == 4 ? _mm_set1_epi32(static_cast<int32_t>(_key)) : _mm_set1_epi64x(static_cast<int64_t>(_key));
+		for (; i + 16 / sizeof(key) <= count; i += 16 / sizeof(key)) {
+			__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+			__m128i eq = _mm_cmpeq_epi32(block, needle);
+			if (sizeof(key) == 8)	// SSE2 has no 64-bit compare: both halves must match
+				eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+			uint32_t bits = static_cast<uint32_t>(_mm_movemask_epi8(eq));
+			if (bits)
+				return i + lowestBit(bits) / sizeof(key);
+		}
+#endif
+		size_t rest = scan(p + i, count - i, _key, std::false_type());
+		return rest == npos ? npos : i + rest;
+	}
+
+	size_t indexOf(const key& _key) const {
+		size_t lo = 0, hi = keys.size();
+		while (hi - lo > SCAN) {
+			this->stats_visit();
+			this->stats_compare();
+			size_t mid = lo + (hi - lo) / 2;
+			if (keys[mid] < _key)
+				lo = mid + 1;
+			else
+				hi = mid + 1;	// mid may be the key itself
+		}
+		this->stats_compare(hi - lo);	// the scan may stop early, count the whole window
+		typedef std::integral_constant<bool, sizeof(key) == 4 || sizeof(key) == 8> vectorized;
+		size_t i = scan(keys.data() + lo, hi - lo, _key, vectorized());
+		return i == npos ? npos : lo + i;
+	}
+
+	// the arrays are about to take one more entry
+	void growing() {
+		if (keys.size() == keys.capacity()) {
+			this->stats_allocate();
+			if (!keys.empty())
+				this->stats_free();
+		}
+	}
+
+public:
+	static const bool ordered = true;	// iteration visits keys in ascending order
+
+	using Stats::stats;
+	using Stats::reset_stats;
+
+	//Iterator:
+	template<typename K, typename V>
+	class iterator {
+	private:
+		const key* keyAt;
+		typename std::conditional<std::is_const<V>::value, const Value*, Value*>::type valAt;
+		size_t pos;
+
+		iterator(const key* k, decltype(valAt) v, size_t p) : keyAt(k), valAt(v), pos(p) {};
+	public:
+		iterator() : keyAt(nullptr), valAt(nullptr), pos(0) {};
+
+		iterator(const iterator& source) : keyAt(source.keyAt), valAt(source.valAt), pos(source.pos) {};
+
+		//Operators
+		iterator& operator++() {
+			pos++;
+			return *this;
+		}
+
+		iterator& operator++(int) {
+			return ++*this;
+		}
+
+		iterator& operator= (const iterator& source) {
+			keyAt = source.keyAt;
+			valAt = source.valAt;
+			pos = source.pos;
+			return *this;
+		}
+
+		bool operator==(const iterator& source) {
+			return pos == source.pos;
+		}
+
+		bool operator!=(const iterator& source) {
+			return pos != source.pos;
+		}
+
+		//Methods
+		const K& getKey() const {
+			return keyAt[pos];
+		}
+
+		const V& getVal() const {
+			return valAt[pos]._val;
+		}
+
+		V& getValRef() {
+			return valAt[pos]._val;
+		}
+
+		friend class Flat_List;
+	};
+	typedef iterator<key, val> Iterator;
+	typedef iterator<const key, const val> Const_Iterator;
+
+	//default iterators
+	Iterator begin() { return Iterator(keys.data(), vals.data(), 0); }
+	Iterator end() { return Iterator(keys.data(), vals.data(), keys.size()); }
+
+	//constant iterators
+	Const_Iterator constBegin() const { return Const_Iterator(keys.data(), vals.data(), 0); }
+	Const_Iterator constEnd() const { return Const_Iterator(keys.data(), vals.data(), keys.size()); }
+
+	//constructor/destructor
+	Flat_List() {}
+
+	bool empty() const { return keys.empty(); }
+
+	int getSize() const { return static_cast<int>(keys.size()); }
+
+	void copy(const Flat_List& toCopy) {
+		keys = toCopy.keys;
+		vals = toCopy.vals;
+	}
+
+	void clear() {
+		keys.clear();
+		vals.clear();
+	}
+
+	void print() const {
+		for (size_t i = 0; i < keys.size(); i++)
+			std::cout << "Key[" << keys[i] << "] = " << vals[i]._val << std::endl;
+	}
+
+	bool find(const key& _key) const {
+		this->stats_begin(STATS_FIND);
+		return indexOf(_key) != npos;
+	}
+
+	// pointer to the value of a key, nullptr when it is missing
+	val* get(const key& _key) {
+		this->stats_begin(STATS_FIND);
+		size_t i = indexOf(_key);
+		return i == npos ? nullptr : &vals[i]._val;
+	}
+
+	// the key must not be smaller than any key in the list
+	void push_back(key _key, val _val) {
+		this->stats_begin(STATS_INSERT);
+		growing();
+		keys.push_back(_key);
+		vals.push_back(Value{ std::move(_val) });
+	}
+
+	// like Linked_List, equal keys keep their insertion order: goes behind them
+	void insert(key _key, val _val) {
+		this->stats_begin(STATS_INSERT);
+		growing();
+		size_t pos = std::upper_bound(keys.begin(), keys.end(), _key, [this](const key& a, const key& b) {
+			this->stats_compare();
+			return a < b;
+		}) - keys.begin();
+		keys.insert(keys.begin() + pos, _key);
+		vals.insert(vals.begin() + pos, Value{ std::move(_val) });
+	}
+
+	bool erase(const key& _key) {
+		this->stats_begin(STATS_ERASE);
+		size_t i = indexOf(_key);
+		if (i == npos)
+			return false;
+		keys.erase(keys.begin() + i);
+		vals.erase(vals.begin() + i);
+		return true;
+	}
+
+	// inserts a range of (key, val) pairs: the batch is sorted and merged with the arrays in one pass.
+	// With unique, keys already present (or earlier in the batch) are skipped
+	template<typename It>
+	void insert_batch(It first, It last, bool unique = false) {
+		std::vector<std::pair<key, val>> batch(first, last);
+		std::stable_sort(batch.begin(), batch.end(), [](const std::pair<key, val>& a, const std::pair<key, val>& b) {
+			return a.first < b.first;
+		});
+
+		this->stats_begin(STATS_INSERT);
+		if (!batch.empty()) {	// the merge builds new arrays
+			this->stats_allocate();
+			if (!keys.empty())
+				this->stats_free();
+		}
+		std::vector<key> mergedKeys;
+		std::vector<Value> mergedVals;
+		mergedKeys.reserve(keys.size() + batch.size());
+		mergedVals.reserve(keys.size() + batch.size());
+		size_t i = 0;
+		for (auto& entry : batch) {
+			for (; i < keys.size() && !(entry.first < keys[i]); i++) {	// behind equal keys, as in insert
+				mergedKeys.push_back(keys[i]);
+				mergedVals.push_back(std::move(vals[i]));
+			}
+			if (unique && !mergedKeys.empty() && mergedKeys.back() == entry.first)
+				continue;
+			mergedKeys.push_back(entry.first);
+			mergedVals.push_back(Value{ std::move(entry.second) });
+		}
+		for (; i < keys.size(); i++) {
+			mergedKeys.push_back(keys[i]);
+			mergedVals.push_back(std::move(vals[i]));
+		}
+		keys.swap(mergedKeys);
+		vals.swap(mergedVals);
+	}
+
+	// value pointer (nullptr when missing) for every key of a range, in input order
+	template<typename It>
+	std::vector<val*> find_many(It first, It last) {
+		std::vector<val*> result;
+		for (; first != last; ++first)
+			result.push_back(get(*first));
+		return result;
+	}
+};
+
+#endif
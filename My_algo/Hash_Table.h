@@ -0,0 +1,410 @@
+#ifndef HASH_TABLE
+#define HASH_TABLE
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <utility>
+#include <vector>
+#include "container_stats.h"
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HASH_TABLE_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Open addressing hash table with the same interface as Linked_List, usable as Dictionary storage.
+// Every slot has a control byte: EMPTY, or the low 7 bits of the key's hash. Lookups scan 16 control
+// bytes at a time (one SSE2 compare) from the key's home slot and only compare keys whose byte matches.
+// Probing is linear and erase shifts the following entries back, so there are never any tombstones.
+// With Ordered = true the iterators walk the entries in key order: insert and erase keep a sorted array of
+// slot indices up to date (binary search plus a shift of the indices), so const readers never write.
+// Stats is an instrumentation policy from container_stats.h; probes count the control groups scanned.
+template<typename key, typename val, bool Ordered = false, typename Hash = std::hash<key>, typename Stats = no_stats>
+class Hash_Table : private Stats
+{
+	struct Node
+	{
+		key _key;
+		val _val;
+		template<typename K, typename V>
+		Node(K&& _k, V&& _v) : _key(std::forward<K>(_k)), _val(std::forward<V>(_v)) {}
+	};
+
+	static const size_t GROUP = 16;
+	static const int8_t EMPTY = -128;
+	static const size_t npos = static_cast<size_t>(-1);
+
+	Node* slots;		// raw storage, only slots with a full control byte hold a Node
+	int8_t* ctrl;		// capacity + GROUP bytes, the last GROUP mirror the first ones so a group never wraps
+	size_t capacity;	// power of two, 0 before the first insert
+	int size;
+	Hash hasher;
+
+	std::vector<size_t> order;	// slot indices in key order, only used when Ordered
+
+	static uint64_t mix(size_t h) {
+		uint64_t x = static_cast<uint64_t>(h) * 0x9E3779B97F4A7C15ull;
+		return x ^ (x >> 32);
+	}
+	static int8_t h2(uint64_t h) { return static_cast<int8_t>(h & 0x7f); }
+	size_t home(uint64_t h) const { return static_cast<size_t>(h >> 7) & (capacity - 1); }
+
+	static unsigned lowestBit(uint32_t bits) {
+#if defined(_MSC_VER)
+		unsigned long i;
+		_BitScanForward(&i, bits);
+		return i;
+#else
+		return __builtin_ctz(bits);
+#endif
+	}
+
+	// bit i is set when ctrl[pos + i] == b
+	static uint32_t match(const int8_t* group, int8_t b) {
+#ifdef HASH_TABLE_SSE2
+		__m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+		return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8(b))));
+#else
+		uint32_t bits = 0;
+		for (size_t i = 0; i < GROUP; i++)
+			if (group[i] == b)
+				bits |= 1u << i;
+		return bits;
+#endif
+	}
+
+	void setCtrl(size_t i, int8_t b) {
+		ctrl[i] = b;
+		if (i < GROUP)
+			ctrl[capacity + i] = b;
+	}
+
+	size_t findSlot(const key& _key) const {
+		if (size == 0)
+			return npos;
+		uint64_t h = mix(hasher(_key));
+		size_t pos = home(h);
+		for (;;) {
+			this->stats_probe();
+			const int8_t* group = ctrl + pos;
+			for (uint32_t bits = match(group, h2(h)); bits; bits &= bits - 1) {
+				size_t i = (pos + lowestBit(bits)) & (capacity - 1);
+				this->stats_visit();
+				this->stats_compare();
+				if (slots[i]._key == _key)
+					return i;
+			}
+			if (match(group, EMPTY))
+				return npos;
+			pos = (pos + GROUP) & (capacity - 1);
+		}
+	}
+
+	// first empty slot on the probe sequence of a hash; the table is never full
+	size_t findEmpty(uint64_t h) const {
+		size_t pos = home(h);
+		for (;;) {
+			this->stats_probe();
+			uint32_t bits = match(ctrl + pos, EMPTY);
+			if (bits)
+				return (pos + lowestBit(bits)) & (capacity - 1);
+			pos = (pos + GROUP) & (capacity - 1);
+		}
+	}
+
+	void allocate(size_t cap) {
+		this->stats_allocate();
+		capacity = cap;
+		slots = static_cast<Node*>(::operator new(sizeof(Node) * cap));
+		ctrl = new int8_t[cap + GROUP];
+		std::memset(ctrl, EMPTY, cap + GROUP);
+	}
+
+	void release() {
+		if (slots)
+			this->stats_free();
+		for (size_t i = 0; i < capacity; i++)
+			if (ctrl[i] != EMPTY)
+				slots[i].~Node();
+		::operator delete(slots);
+		delete[] ctrl;
+		slots = nullptr;
+		ctrl = nullptr;
+		capacity = 0;
+	}
+
+	// keeps the load factor at or below 7/8
+	void reserveOneMore() {
+		if (capacity && static_cast<size_t>(size + 1) * 8 <= capacity * 7)
+			return;
+		Node* oldSlots = slots;
+		int8_t* oldCtrl = ctrl;
+		size_t oldCapacity = capacity;
+		std::vector<size_t> moved(Ordered ? oldCapacity : 0);	// new slot of every old one
+		allocate(capacity ? capacity * 2 : GROUP);
+		for (size_t i = 0; i < oldCapacity; i++) {
+			if (oldCtrl[i] == EMPTY)
+				continue;
+			uint64_t h = mix(hasher(oldSlots[i]._key));
+			size_t j = findEmpty(h);
+			new (&slots[j]) Node(std::move(oldSlots[i]._key), std::move(oldSlots[i]._val));
+			setCtrl(j, h2(h));
+			oldSlots[i].~Node();
+			if (Ordered)
+				moved[i] = j;
+		}
+		for (size_t& i : order)
+			i = moved[i];
+		if (oldSlots)
+			this->stats_free();
+		::operator delete(oldSlots);
+		delete[] oldCtrl;
+	}
+
+	// where _key is, or would go, in order
+	std::vector<size_t>::iterator orderFind(const key& _key) {
+		return std::lower_bound(order.begin(), order.end(), _key, [this](size_t i, const key& k) { return slots[i]._key < k; });
+	}
+
+	// position of the first entry: a slot index, or an index into order
+	size_t first() const {
+		if (Ordered)
+			return order.empty() ? npos : 0;
+		return nextFull(0);
+	}
+
+	size_t nextFull(size_t i) const {
+		for (; i < capacity; i++)
+			if (ctrl[i] != EMPTY)
+				return i;
+		return npos;
+	}
+
+public:
+	static const bool ordered = Ordered;	// iteration visits keys in ascending order
+
+	using Stats::stats;
+	using Stats::reset_stats;
+
+	//Iterator:
+	template<typename K, typename V>
+	class iterator {
+	private:
+		const Hash_Table* table;
+		size_t pos;
+
+		iterator(const Hash_Table* t, size_t p) : table(t), pos(p) {};
+
+		Node* node() const {
+			return &table->slots[Ordered ? table->order[pos] : pos];
+		}
+	public:
+		iterator() : table(nullptr), pos(npos) {};
+
+		iterator(const iterator& source) : table(source.table), pos(source.pos) {};
+
+		//Operators
+		iterator& operator++() {
+			if (pos != npos) {
+				if (Ordered)
+					pos = pos + 1 < table->order.size() ? pos + 1 : npos;
+				else
+					pos = table->nextFull(pos + 1);
+			}
+			return *this;
+		}
+
+		iterator& operator++(int) {
+			return ++*this;
+		}
+
+		iterator& operator= (const iterator& source) {
+			table = source.table;
+			pos = source.pos;
+			return *this;
+		}
+
+		Node& operator* () {
+			return *node();
+		}
+
+		Node* operator->() {
+			return node();
+		}
+
+		bool operator==(const iterator& source) {
+			return pos == source.pos;
+		}
+
+		bool operator!=(const iterator& source) {
+			return pos != source.pos;
+		}
+
+		//Methods
+		const K& getKey() const {
+			return node()->_key;
+		}
+
+		const V& getVal() const {
+			return node()->_val;
+		}
+
+		V& getValRef() {
+			return node()->_val;
+		}
+
+		friend class Hash_Table;
+	};
+	typedef iterator<key, val> Iterator;
+	typedef iterator<const key, const val> Const_Iterator;
+
+	//default iterators
+	Iterator begin() { return Iterator(this, first()); }
+	Iterator end() { return Iterator(this, npos); }
+
+	//constant iterators
+	Const_Iterator constBegin() const { return Const_Iterator(this, first()); }
+	Const_Iterator constEnd() const { return Const_Iterator(this, npos); }
+
+	//constructor/destructor
+	Hash_Table() : slots(nullptr), ctrl(nullptr), capacity(0), size(0) {}
+	~Hash_Table() { this->release(); }
+
+	bool empty() const { return size == 0; }
+
+	int getSize() const { return size; }
+
+	//copy constructor
+	Hash_Table(const Hash_Table& newTable) : slots(nullptr), ctrl(nullptr), capacity(0), size(0) {
+		this->copy(newTable);
+	}
+
+	Hash_Table& operator= (const Hash_Table& newTable) {
+		if (this != &newTable)
+			this->copy(newTable);
+		return *this;
+	}
+
+	//move constructor
+	Hash_Table(Hash_Table&& newTable) noexcept : slots(nullptr), ctrl(nullptr), capacity(0), size(0) {
+		this->swap(newTable);
+	}
+
+	Hash_Table& operator= (Hash_Table&& newTable) noexcept {
+		if (this != &newTable) {
+			this->clear();
+			this->swap(newTable);
+		}
+		return *this;
+	}
+
+	void swap(Hash_Table& other) noexcept {
+		std::swap(slots, other.slots);
+		std::swap(ctrl, other.ctrl);
+		std::swap(capacity, other.capacity);
+		std::swap(size, other.size);
+		std::swap(hasher, other.hasher);
+		order.swap(other.order);
+	}
+
+	void copy(const Hash_Table& toCopy) {
+		this->clear();
+		for (size_t i = 0; i < toCopy.capacity; i++)
+			if (toCopy.ctrl[i] != EMPTY)
+				this->insert(toCopy.slots[i]._key, toCopy.slots[i]._val);
+	}
+
+	void clear() {
+		this->release();
+		size = 0;
+		order.clear();
+	}
+
+	void print() const {
+		for (auto it = constBegin(); it != constEnd(); ++it)
+			std::cout << "Key[" << it.getKey() << "] = " << it.getVal() << std::endl;
+	}
+
+	bool find(const key& _key) const {
+		this->stats_begin(STATS_FIND);
+		return findSlot(_key) != npos;
+	}
+
+	// pointer to the value of a key, nullptr when it is missing
+	val* get(const key& _key) {
+		this->stats_begin(STATS_FIND);
+		size_t i = findSlot(_key);
+		return i == npos ? nullptr : &slots[i]._val;
+	}
+
+	// does nothing if the key is already present
+	void insert(key _key, val _val) {
+		this->stats_begin(STATS_INSERT);
+		if (findSlot(_key) != npos)
+			return;
+		reserveOneMore();
+		uint64_t h = mix(hasher(_key));
+		size_t i = findEmpty(h);
+		new (&slots[i]) Node(std::move(_key), std::move(_val));
+		setCtrl(i, h2(h));
+		size++;
+		if (Ordered)
+			order.insert(orderFind(slots[i]._key), i);
+	}
+
+	// for storages that append in key order; a hash table just inserts
+	void push_back(key _key, val _val) {
+		insert(std::move(_key), std::move(_val));
+	}
+
+	// inserts a range of (key, val) pairs; keys are unique in a hash table anyway
+	template<typename It>
+	void insert_batch(It first, It last, bool /*unique*/ = true) {
+		for (; first != last; ++first)
+			insert(first->first, first->second);
+	}
+
+	// value pointer (nullptr when missing) for every key of a range, in input order
+	template<typename It>
+	std::vector<val*> find_many(It first, It last) {
+		std::vector<val*> result;
+		for (; first != last; ++first)
+			result.push_back(get(*first));
+		return result;
+	}
+
+	bool erase(const key& _key) {
+		this->stats_begin(STATS_ERASE);
+		size_t i = findSlot(_key);
+		if (i == npos)
+			return false;
+		if (Ordered)
+			order.erase(orderFind(slots[i]._key));
+		slots[i].~Node();
+		size_t mask = capacity - 1;
+		// backward shift: pull later entries of the run into the hole if that keeps them reachable from home
+		for (size_t j = (i + 1) & mask; ctrl[j] != EMPTY; j = (j + 1) & mask) {
+			this->stats_probe();
+			size_t h = home(mix(hasher(slots[j]._key)));
+			if (((j - h) & mask) >= ((j - i) & mask)) {
+				if (Ordered)
+					*orderFind(slots[j]._key) = i;
+				new (&slots[i]) Node(std::move(slots[j]._key), std::move(slots[j]._val));
+				slots[j].~Node();
+				setCtrl(i, ctrl[j]);
+				i = j;
+			}
+		}
+		setCtrl(i, EMPTY);
+		size--;
+		return true;
+	}
+};
+
+#endif
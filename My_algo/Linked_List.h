@@ -1,16 +1,23 @@
 #ifndef LINKED_LIST
 #define LINKED_LIST
+#include <algorithm>
+#include <cstddef>
 #include <iostream>
+#include <utility>
+#include <vector>
+#include "container_stats.h"
 
-template<typename key, typename val>
-class Linked_List
+// Stats is an instrumentation policy from container_stats.h, e.g. counting_stats
+template<typename key, typename val, typename Stats = no_stats>
+class Linked_List : private Stats
 {
 	struct Node
 	{
 		key _key;
 		val _val;
 		Node* next;
-		Node(key _k, val _v) : _key(_k), _val(_v), next(nullptr) {}
+		template<typename K, typename V>
+		Node(K&& _k, V&& _v) : _key(std::forward<K>(_k)), _val(std::forward<V>(_v)), next(nullptr) {}
 	};
 
 	Node* head;
@@ -18,6 +25,11 @@ class Linked_List
 	int size;
 
 public:
+	static const bool ordered = true;	// iteration visits keys in ascending order
+
+	using Stats::stats;
+	using Stats::reset_stats;
+
 	//Iterator:
 	template<typename K, typename V>
 	class iterator {
@@ -67,11 +79,11 @@ public:
 		}
 
 		//Methods
-		K getKey() const {
+		const K& getKey() const {
 			return current->_key;
 		}
 
-		V getVal() const {
+		const V& getVal() const {
 			return current->_val;
 		}
 
@@ -101,20 +113,41 @@ public:
 	int getSize() const { return size; }
 
 	//copy constructor
-	Linked_List(const Linked_List<key, val>& newList) {
+	Linked_List(const Linked_List& newList) : head(nullptr), tail(nullptr), size(0) {
 		this->copy(newList);
 	}
 
-	Linked_List<key, val>& operator= (const Linked_List<key, val>& newList) {
-		this->copy(newList);
+	Linked_List& operator= (const Linked_List& newList) {
+		if (this != &newList)
+			this->copy(newList);
+		return *this;
+	}
+
+	//move constructor
+	Linked_List(Linked_List&& newList) noexcept : head(newList.head), tail(newList.tail), size(newList.size) {
+		newList.head = nullptr;
+		newList.tail = nullptr;
+		newList.size = 0;
+	}
+
+	Linked_List& operator= (Linked_List&& newList) noexcept {
+		if (this != &newList) {
+			this->clear();
+			head = newList.head;
+			tail = newList.tail;
+			size = newList.size;
+			newList.head = nullptr;
+			newList.tail = nullptr;
+			newList.size = 0;
+		}
 		return *this;
 	}
 
-	void copy(const Linked_List<key, val>& toCopy) {
+	void copy(const Linked_List& toCopy) {
 		this->clear();
 		Node* curr = toCopy.head;
-		while (curr) {
-			this->insert(curr->_key, curr->_val);
+		while (curr) {	// the source is already sorted, so appending keeps the order
+			this->push_back(curr->_key, curr->_val);
 			curr = curr->next;
 		}
 	}
@@ -127,6 +160,7 @@ public:
 			toDelete = head;
 			head = head->next;
 			delete toDelete;
+			this->stats_free();
 		}
 
 		head = nullptr;
@@ -141,9 +175,12 @@ public:
 		}
 	}
 
-	bool find(const key _key) const {
+	bool find(const key& _key) const {
+		this->stats_begin(STATS_FIND);
 		Node* curr = head;
 		while (curr) {
+			this->stats_visit();
+			this->stats_compare();
 			if (curr->_key == _key) {
 				return true;
 			}
@@ -153,35 +190,79 @@ public:
 		return false;
 	}
 
+	// pointer to the value of a key, nullptr when it is missing
+	val* get(const key& _key) {
+		this->stats_begin(STATS_FIND);
+		Node* curr = head;
+		while (curr) {
+			this->stats_visit();
+			this->stats_compare();
+			if (curr->_key == _key) {
+				return &curr->_val;
+			}
+			curr = curr->next;
+		}
+
+		return nullptr;
+	}
+
 	void push_back(key _key, val _val) {
-		Node* newNode = new Node(_key, _val);
-		tail->next = newNode;
+		this->stats_begin(STATS_INSERT);
+		this->stats_allocate();
+		Node* newNode = new Node(std::move(_key), std::move(_val));
+		if (tail)
+			tail->next = newNode;
+		else
+			head = newNode;
 		tail = newNode;
+		size++;
 	}
 
 	void push_front(key _key, val _val) {
-		Node* newNode = new Node(_key, _val);
+		this->stats_begin(STATS_INSERT);
+		this->stats_allocate();
+		Node* newNode = new Node(std::move(_key), std::move(_val));
 		newNode->next = head;
 		head = newNode;
+		if (!tail)
+			tail = newNode;
+		size++;
 	}
 
 	void insert(key _key, val _val);
+
+	// inserts a range of (key, val) pairs: the batch is sorted and merged into the list in one pass,
+	// O(n + m log m) instead of m scans from head. With unique, keys already present (or earlier in
+	// the batch) are skipped, as Dictionary::insert would
+	template<typename It>
+	void insert_batch(It first, It last, bool unique = false);
+
+	// looks up a range of keys; the result holds a value pointer (nullptr when missing) for every key
+	// in input order. The keys are sorted and answered in one traversal, O(n + m log m)
+	template<typename It>
+	std::vector<val*> find_many(It first, It last);
 };
 
-template<typename key, typename val>
-void Linked_List<key, val>::insert(key _key, val _val) {
+template<typename key, typename val, typename Stats>
+void Linked_List<key, val, Stats>::insert(key _key, val _val) {
+	this->stats_begin(STATS_INSERT);
+	this->stats_allocate();
 	this->size++;
 
 	if (!head) {
-		head = new Linked_List::Node(_key, _val);
+		head = new Linked_List::Node(std::move(_key), std::move(_val));
 		tail = head;
 		return;
 	}
 
 	Linked_List::Node* curr = head;
-	Linked_List::Node* newNode = new Node(_key, _val);
+	Linked_List::Node* newNode = new Node(std::move(_key), std::move(_val));
+
+	const key& newKey = newNode->_key;	// _key itself was moved into the node
 
-	if (curr->_key > _key) {
+	this->stats_visit();
+	this->stats_compare();
+	if (curr->_key > newKey) {
 		newNode->next = head;
 		head = newNode;
 		return;
@@ -191,7 +272,9 @@ void Linked_List<key, val>::insert(key _key, val _val) {
 	curr = curr->next;
 
 	while (curr) {
-		if (_key < curr->_key) {
+		this->stats_visit();
+		this->stats_compare();
+		if (newKey < curr->_key) {
 			prev->next = newNode;
 			newNode->next = curr;
 			return;
@@ -204,4 +287,68 @@ void Linked_List<key, val>::insert(key _key, val _val) {
 	tail = newNode;
 }
 
+template<typename key, typename val, typename Stats>
+template<typename It>
+void Linked_List<key, val, Stats>::insert_batch(It first, It last, bool unique) {
+	std::vector<std::pair<key, val>> batch(first, last);
+	// stable, so equal keys keep their batch order like repeated insert calls would
+	std::stable_sort(batch.begin(), batch.end(), [](const std::pair<key, val>& a, const std::pair<key, val>& b) {
+		return a.first < b.first;
+	});
+
+	this->stats_begin(STATS_INSERT);
+	Linked_List::Node* prev = nullptr;
+	Linked_List::Node* curr = head;
+	for (auto& entry : batch) {
+		while (curr && !(entry.first < curr->_key)) {	// behind equal keys, as in insert
+			this->stats_visit();
+			this->stats_compare();
+			prev = curr;
+			curr = curr->next;
+		}
+		if (unique && prev) {
+			this->stats_compare();
+			if (prev->_key == entry.first)
+				continue;
+		}
+
+		this->stats_allocate();
+		Linked_List::Node* newNode = new Node(std::move(entry.first), std::move(entry.second));
+		newNode->next = curr;
+		if (prev)
+			prev->next = newNode;
+		else
+			head = newNode;
+		if (!curr)
+			tail = newNode;
+		prev = newNode;
+		this->size++;
+	}
+}
+
+template<typename key, typename val, typename Stats>
+template<typename It>
+std::vector<val*> Linked_List<key, val, Stats>::find_many(It first, It last) {
+	std::vector<key> keys(first, last);
+	std::vector<size_t> order(keys.size());
+	for (size_t i = 0; i < order.size(); i++)
+		order[i] = i;
+	std::sort(order.begin(), order.end(), [&keys](size_t a, size_t b) { return keys[a] < keys[b]; });
+
+	this->stats_begin(STATS_FIND);
+	std::vector<val*> result(keys.size(), nullptr);
+	Linked_List::Node* curr = head;
+	for (size_t i : order) {
+		while (curr && curr->_key < keys[i]) {
+			this->stats_visit();
+			this->stats_compare();
+			curr = curr->next;
+		}
+		this->stats_compare(curr ? 2 : 0);
+		if (curr && curr->_key == keys[i])
+			result[i] = &curr->_val;
+	}
+	return result;
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,360 @@
+#ifndef SKIP_LIST
+#define SKIP_LIST
+#include <cstdint>
+#include <iostream>
+#include <new>
+#include <utility>
+#include <vector>
+#include "container_stats.h"
+
+// Sorted list with the same interface as Linked_List, but every node also sits on a random number
+// of express levels (each level holds about a quarter of the nodes of the one below), so insert,
+// find and erase take expected O(log n) instead of a scan from head. Usable as Dictionary storage.
+// Stats is an instrumentation policy from container_stats.h
+template<typename key, typename val, typename Stats = no_stats>
+class Skip_List : private Stats
+{
+	static const int MAX_LEVEL = 16;	// enough for 4^16 entries
+
+	struct Node
+	{
+		key _key;
+		val _val;
+		int levels;
+		Node** next;	// levels pointers, stored right after the node in the same allocation
+
+		template<typename K, typename V>
+		Node(K&& _k, V&& _v, int _levels) : _key(std::forward<K>(_k)), _val(std::forward<V>(_v)), levels(_levels) {
+			next = reinterpret_cast<Node**>(this + 1);
+			for (int i = 0; i < levels; i++)
+				next[i] = nullptr;
+		}
+	};
+
+	Node* head[MAX_LEVEL];	// first node on every level
+	Node* last[MAX_LEVEL];	// last node on every level, for appends
+	int level;		// number of levels in use
+	int size;
+	uint32_t seed;
+
+	template<typename K, typename V>
+	Node* createNode(K&& _k, V&& _v, int levels) {
+		this->stats_allocate();
+		void* memory = ::operator new(sizeof(Node) + levels * sizeof(Node*));
+		return new (memory) Node(std::forward<K>(_k), std::forward<V>(_v), levels);
+	}
+
+	void destroyNode(Node* node) {
+		this->stats_free();
+		node->~Node();
+		::operator delete(node);
+	}
+
+	int randomLevel() {
+		seed ^= seed << 13;	// xorshift32
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		int levels = 1;
+		for (uint32_t bits = seed; levels < MAX_LEVEL && (bits & 3) == 0; bits >>= 2)
+			levels++;
+		return levels;
+	}
+
+	// fills update[i] with the next-array whose slot i precedes the position of _key;
+	// with after_equal the position is behind the keys equal to _key, otherwise in front of them
+	void findPath(const key& _key, Node** update[], bool after_equal) {
+		Node** x = head;
+		for (int i = level - 1; i >= 0; i--) {
+			while (x[i] && (after_equal ? !(_key < x[i]->_key) : x[i]->_key < _key)) {
+				this->stats_visit();
+				this->stats_compare();
+				x = x[i]->next;
+			}
+			this->stats_compare(x[i] ? 1 : 0);
+			update[i] = x;
+		}
+	}
+
+	Node* findNode(const key& _key) const {
+		Node* const* x = head;
+		for (int i = level - 1; i >= 0; i--) {
+			while (x[i] && x[i]->_key < _key) {
+				this->stats_visit();
+				this->stats_compare();
+				x = x[i]->next;
+			}
+			this->stats_compare(x[i] ? 1 : 0);
+		}
+		Node* candidate = level ? x[0] : nullptr;
+		this->stats_compare(candidate ? 1 : 0);
+		if (candidate && candidate->_key == _key)
+			return candidate;
+		return nullptr;
+	}
+
+	// the node whose next-array is links, nullptr for head
+	Node* owner(Node** links) {
+		return links == head ? nullptr : reinterpret_cast<Node*>(links) - 1;
+	}
+
+	void reset() {
+		for (int i = 0; i < MAX_LEVEL; i++) {
+			head[i] = nullptr;
+			last[i] = nullptr;
+		}
+		level = 0;
+		size = 0;
+	}
+
+public:
+	static const bool ordered = true;	// iteration visits keys in ascending order
+
+	using Stats::stats;
+	using Stats::reset_stats;
+
+	//Iterator:
+	template<typename K, typename V>
+	class iterator {
+	private:
+		Node* current;
+
+		iterator(Node* curr) : current(curr) {};
+	public:
+		iterator() : current(nullptr) {};
+
+		iterator(const iterator& source) : current(source.current) {};
+
+		//Operators
+		iterator& operator++() {
+			if (current) {
+				current = current->next[0];
+			}
+			return *this;
+		}
+
+		iterator& operator++(int) {
+			if (current) {
+				current = current->next[0];
+			}
+			return *this;
+		}
+
+		iterator& operator= (const iterator& source) {
+			current = source.current;
+			return *this;
+		}
+
+		Node& operator* () {
+			return *current;
+		}
+
+		Node* operator->() {
+			return current;
+		}
+
+		bool operator==(const iterator& source) {
+			return current == source.current;
+		}
+
+		bool operator!=(const iterator& source) {
+			return current != source.current;
+		}
+
+		//Methods
+		const K& getKey() const {
+			return current->_key;
+		}
+
+		const V& getVal() const {
+			return current->_val;
+		}
+
+		V& getValRef() {
+			return current->_val;
+		}
+
+		friend class Skip_List;
+	};
+	typedef iterator<key, val> Iterator;
+	typedef iterator<const key, const val> Const_Iterator;
+
+	//default iterators
+	Iterator begin() { return Iterator(head[0]); }
+	Iterator end() { return nullptr; }
+
+	//constant iterators
+	Const_Iterator constBegin() const { return Const_Iterator(head[0]); }
+	Const_Iterator constEnd() const { return nullptr; }
+
+	//constructor/destructor
+	Skip_List() : seed(2463534242u) { reset(); }
+	~Skip_List() { this->clear(); }
+
+	bool empty() const { return head[0] == nullptr; }
+
+	int getSize() const { return size; }
+
+	//copy constructor
+	Skip_List(const Skip_List& newList) : seed(2463534242u) {
+		reset();
+		this->copy(newList);
+	}
+
+	Skip_List& operator= (const Skip_List& newList) {
+		if (this != &newList)
+			this->copy(newList);
+		return *this;
+	}
+
+	//move constructor
+	Skip_List(Skip_List&& newList) noexcept : seed(newList.seed) {
+		reset();
+		this->swap(newList);
+	}
+
+	Skip_List& operator= (Skip_List&& newList) noexcept {
+		if (this != &newList) {
+			this->clear();
+			this->swap(newList);
+		}
+		return *this;
+	}
+
+	void swap(Skip_List& other) noexcept {
+		for (int i = 0; i < MAX_LEVEL; i++) {
+			std::swap(head[i], other.head[i]);
+			std::swap(last[i], other.last[i]);
+		}
+		std::swap(level, other.level);
+		std::swap(size, other.size);
+		std::swap(seed, other.seed);
+	}
+
+	void copy(const Skip_List& toCopy) {
+		this->clear();
+		Node* curr = toCopy.head[0];
+		while (curr) {
+			this->push_back(curr->_key, curr->_val);
+			curr = curr->next[0];
+		}
+	}
+
+	void clear() {
+		Node* curr = head[0];
+		while (curr) {
+			Node* toDelete = curr;
+			curr = curr->next[0];
+			destroyNode(toDelete);
+		}
+		reset();
+	}
+
+	void print() const {
+		Node* curr = head[0];
+		while (curr) {
+			std::cout << "Key[" << curr->_key << "] = " << curr->_val << std::endl;
+			curr = curr->next[0];
+		}
+	}
+
+	bool find(const key& _key) const {
+		this->stats_begin(STATS_FIND);
+		return findNode(_key) != nullptr;
+	}
+
+	// pointer to the value of a key, nullptr when it is missing
+	val* get(const key& _key) {
+		this->stats_begin(STATS_FIND);
+		Node* node = findNode(_key);
+		return node ? &node->_val : nullptr;
+	}
+
+	// the key must not be smaller than any key in the list; links the node behind the last one
+	// of every level it is on, expected O(1), so copies and merge-joins build lists in linear time
+	void push_back(key _key, val _val);
+
+	// inserts a range of (key, val) pairs; with unique, keys already present are skipped.
+	// Every insert is already O(log n), so the batch needs no sorting
+	template<typename It>
+	void insert_batch(It first, It last, bool unique = false) {
+		for (; first != last; ++first)
+			if (!unique || !find(first->first))
+				insert(first->first, first->second);
+	}
+
+	// value pointer (nullptr when missing) for every key of a range, in input order
+	template<typename It>
+	std::vector<val*> find_many(It first, It last) {
+		std::vector<val*> result;
+		for (; first != last; ++first)
+			result.push_back(get(*first));
+		return result;
+	}
+
+	void insert(key _key, val _val);
+	bool erase(const key& _key);
+};
+
+template<typename key, typename val, typename Stats>
+void Skip_List<key, val, Stats>::insert(key _key, val _val) {
+	this->stats_begin(STATS_INSERT);
+	Node** update[MAX_LEVEL];
+	findPath(_key, update, true);	// like Linked_List, equal keys keep their insertion order
+
+	int levels = randomLevel();
+	for (int i = level; i < levels; i++)
+		update[i] = head;
+	if (levels > level)
+		level = levels;
+
+	Node* newNode = createNode(std::move(_key), std::move(_val), levels);
+	for (int i = 0; i < levels; i++) {
+		newNode->next[i] = update[i][i];
+		update[i][i] = newNode;
+		if (!newNode->next[i])
+			last[i] = newNode;
+	}
+	size++;
+}
+
+template<typename key, typename val, typename Stats>
+void Skip_List<key, val, Stats>::push_back(key _key, val _val) {
+	this->stats_begin(STATS_INSERT);
+	int levels = randomLevel();
+	if (levels > level)
+		level = levels;
+
+	Node* newNode = createNode(std::move(_key), std::move(_val), levels);
+	for (int i = 0; i < levels; i++) {
+		if (last[i])
+			last[i]->next[i] = newNode;
+		else
+			head[i] = newNode;
+		last[i] = newNode;
+	}
+	size++;
+}
+
+template<typename key, typename val, typename Stats>
+bool Skip_List<key, val, Stats>::erase(const key& _key) {
+	this->stats_begin(STATS_ERASE);
+	Node** update[MAX_LEVEL];
+	findPath(_key, update, false);
+
+	Node* toDelete = level ? update[0][0] : nullptr;
+	if (!toDelete || !(toDelete->_key == _key))
+		return false;
+
+	for (int i = 0; i < toDelete->levels; i++) {
+		update[i][i] = toDelete->next[i];
+		if (last[i] == toDelete)
+			last[i] = owner(update[i]);
+	}
+	destroyNode(toDelete);
+	while (level > 0 && head[level - 1] == nullptr)
+		level--;
+	size--;
+	return true;
+}
+
+#endif
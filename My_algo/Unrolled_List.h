@@ -0,0 +1,371 @@
+#ifndef UNROLLED_LIST
+#define UNROLLED_LIST
+#include <cstddef>
+#include <iostream>
+#include <new>
+#include <utility>
+#include <vector>
+#include "container_stats.h"
+
+// Sorted list with the Linked_List interface whose nodes each hold up to Capacity entries, keys
+// and values in two small sorted arrays. Scans touch one node (and one cache miss) per Capacity
+// entries and the next pointer is shared by all of them. A full node is split in half on insert,
+// and a node that drops below half full on erase takes over its successor if both fit in one.
+// Usable as Dictionary storage. Stats is an instrumentation policy from container_stats.h
+template<typename key, typename val, int Capacity = 16, typename Stats = no_stats>
+class Unrolled_List : private Stats
+{
+	static_assert(Capacity >= 2, "a node must hold at least two entries");
+
+	struct Node
+	{
+		int count;
+		Node* next;
+		alignas(key) unsigned char keyStorage[sizeof(key) * Capacity];
+		alignas(val) unsigned char valStorage[sizeof(val) * Capacity];
+
+		Node() : count(0), next(nullptr) {}
+		~Node() {
+			for (int i = 0; i < count; i++) {
+				keys()[i].~key();
+				vals()[i].~val();
+			}
+		}
+
+		key* keys() { return reinterpret_cast<key*>(keyStorage); }
+		val* vals() { return reinterpret_cast<val*>(valStorage); }
+		const key* keys() const { return reinterpret_cast<const key*>(keyStorage); }
+		const val* vals() const { return reinterpret_cast<const val*>(valStorage); }
+
+		const key& last() const { return keys()[count - 1]; }
+
+		// moves entry from into the unconstructed slot to of dest
+		void moveTo(int from, Node* dest, int to) {
+			new (&dest->keys()[to]) key(std::move(keys()[from]));
+			new (&dest->vals()[to]) val(std::move(vals()[from]));
+			keys()[from].~key();
+			vals()[from].~val();
+		}
+
+		// opens an unconstructed slot at pos by shifting the entries behind it up
+		void openAt(int pos) {
+			for (int i = count; i > pos; i--)
+				moveTo(i - 1, this, i);
+		}
+
+		// closes the unconstructed slot at pos by shifting the entries behind it down
+		void closeAt(int pos) {
+			for (int i = pos; i + 1 < count; i++)
+				moveTo(i + 1, this, i);
+		}
+	};
+
+	Node* head;
+	Node* tail;
+	int size;
+
+	// first node that may hold _key: the last key of every node before it is smaller
+	Node* findNode(const key& _key, Node** prev) const {
+		Node* p = nullptr;
+		Node* curr = head;
+		while (curr && curr->last() < _key) {
+			this->stats_visit();
+			this->stats_compare();
+			p = curr;
+			curr = curr->next;
+		}
+		if (prev)
+			*prev = p;
+		return curr;
+	}
+
+	// index of _key inside node, or -1
+	int indexOf(const Node* node, const key& _key) const {
+		this->stats_visit();
+		for (int i = 0; i < node->count; i++) {
+			this->stats_compare();
+			if (node->keys()[i] == _key)
+				return i;
+			if (_key < node->keys()[i])
+				break;
+		}
+		return -1;
+	}
+
+	// moves the upper half of a full node into a new node right after it
+	void split(Node* node) {
+		this->stats_allocate();
+		Node* upper = new Node;
+		int half = node->count / 2;
+		for (int i = half; i < node->count; i++)
+			node->moveTo(i, upper, i - half);
+		upper->count = node->count - half;
+		node->count = half;
+		upper->next = node->next;
+		node->next = upper;
+		if (tail == node)
+			tail = upper;
+	}
+
+	template<typename K, typename V>
+	void emplaceAt(Node* node, int pos, K&& _key, V&& _val) {
+		node->openAt(pos);
+		new (&node->keys()[pos]) key(std::forward<K>(_key));
+		new (&node->vals()[pos]) val(std::forward<V>(_val));
+		node->count++;
+		size++;
+	}
+
+public:
+	static const bool ordered = true;	// iteration visits keys in ascending order
+
+	using Stats::stats;
+	using Stats::reset_stats;
+
+	//Iterator:
+	template<typename K, typename V>
+	class iterator {
+	private:
+		Node* current;
+		int index;
+
+		iterator(Node* curr) : current(curr), index(0) {};
+	public:
+		iterator() : current(nullptr), index(0) {};
+
+		iterator(const iterator& source) : current(source.current), index(source.index) {};
+
+		//Operators
+		iterator& operator++() {
+			if (current && ++index == current->count) {
+				current = current->next;
+				index = 0;
+			}
+			return *this;
+		}
+
+		iterator& operator++(int) {
+			return ++*this;
+		}
+
+		iterator& operator= (const iterator& source) {
+			current = source.current;
+			index = source.index;
+			return *this;
+		}
+
+		bool operator==(const iterator& source) {
+			return current == source.current && index == source.index;
+		}
+
+		bool operator!=(const iterator& source) {
+			return !(*this == source);
+		}
+
+		//Methods
+		const K& getKey() const {
+			return current->keys()[index];
+		}
+
+		const V& getVal() const {
+			return current->vals()[index];
+		}
+
+		V& getValRef() {
+			return current->vals()[index];
+		}
+
+		friend class Unrolled_List;
+	};
+	typedef iterator<key, val> Iterator;
+	typedef iterator<const key, const val> Const_Iterator;
+
+	//default iterators
+	Iterator begin() { return Iterator(head); }
+	Iterator end() { return nullptr; }
+
+	//constant iterators
+	Const_Iterator constBegin() const { return Const_Iterator(head); }
+	Const_Iterator constEnd() const { return nullptr; }
+
+	//constructor/destructor
+	Unrolled_List() : head(nullptr), tail(nullptr), size(0) {}
+	~Unrolled_List() { this->clear(); }
+
+	bool empty() const { return head == nullptr; }
+
+	int getSize() const { return size; }
+
+	//copy constructor
+	Unrolled_List(const Unrolled_List& newList) : head(nullptr), tail(nullptr), size(0) {
+		this->copy(newList);
+	}
+
+	Unrolled_List& operator= (const Unrolled_List& newList) {
+		if (this != &newList)
+			this->copy(newList);
+		return *this;
+	}
+
+	//move constructor
+	Unrolled_List(Unrolled_List&& newList) noexcept : head(newList.head), tail(newList.tail), size(newList.size) {
+		newList.head = nullptr;
+		newList.tail = nullptr;
+		newList.size = 0;
+	}
+
+	Unrolled_List& operator= (Unrolled_List&& newList) noexcept {
+		if (this != &newList) {
+			this->clear();
+			head = newList.head;
+			tail = newList.tail;
+			size = newList.size;
+			newList.head = nullptr;
+			newList.tail = nullptr;
+			newList.size = 0;
+		}
+		return *this;
+	}
+
+	void copy(const Unrolled_List& toCopy) {
+		this->clear();
+		for (Node* curr = toCopy.head; curr; curr = curr->next)
+			for (int i = 0; i < curr->count; i++)
+				this->push_back(curr->keys()[i], curr->vals()[i]);
+	}
+
+	void clear() {
+		while (head) {
+			Node* toDelete = head;
+			head = head->next;
+			delete toDelete;
+			this->stats_free();
+		}
+		tail = nullptr;
+		size = 0;
+	}
+
+	void print() const {
+		for (Node* curr = head; curr; curr = curr->next)
+			for (int i = 0; i < curr->count; i++)
+				std::cout << "Key[" << curr->keys()[i] << "] = " << curr->vals()[i] << std::endl;
+	}
+
+	bool find(const key& _key) const {
+		this->stats_begin(STATS_FIND);
+		Node* node = findNode(_key, nullptr);
+		return node && indexOf(node, _key) >= 0;
+	}
+
+	// pointer to the value of a key, nullptr when it is missing
+	val* get(const key& _key) {
+		this->stats_begin(STATS_FIND);
+		Node* node = findNode(_key, nullptr);
+		int i = node ? indexOf(node, _key) : -1;
+		return i >= 0 ? &node->vals()[i] : nullptr;
+	}
+
+	// the key must not be smaller than any key in the list
+	void push_back(key _key, val _val) {
+		this->stats_begin(STATS_INSERT);
+		if (!tail || tail->count == Capacity) {
+			this->stats_allocate();
+			Node* newNode = new Node;
+			if (tail)
+				tail->next = newNode;
+			else
+				head = newNode;
+			tail = newNode;
+		}
+		emplaceAt(tail, tail->count, std::move(_key), std::move(_val));
+	}
+
+	// inserts a range of (key, val) pairs; with unique, keys already present are skipped.
+	// Inserts only shift within one node, so the batch is not merged
+	template<typename It>
+	void insert_batch(It first, It last, bool unique = false) {
+		for (; first != last; ++first)
+			if (!unique || !find(first->first))
+				insert(first->first, first->second);
+	}
+
+	// value pointer (nullptr when missing) for every key of a range, in input order
+	template<typename It>
+	std::vector<val*> find_many(It first, It last) {
+		std::vector<val*> result;
+		for (; first != last; ++first)
+			result.push_back(get(*first));
+		return result;
+	}
+
+	void insert(key _key, val _val);
+	bool erase(const key& _key);
+};
+
+template<typename key, typename val, int Capacity, typename Stats>
+void Unrolled_List<key, val, Capacity, Stats>::insert(key _key, val _val) {
+	// like Linked_List, equal keys keep their insertion order: go behind them
+	Node* node = head;
+	if (!node) {
+		push_back(std::move(_key), std::move(_val));
+		return;
+	}
+	this->stats_begin(STATS_INSERT);
+	while (node->next && !(_key < node->last())) {
+		this->stats_visit();
+		this->stats_compare();
+		node = node->next;
+	}
+
+	if (node->count == Capacity) {
+		split(node);
+		if (!(_key < node->last()))
+			node = node->next;
+	}
+
+	int pos = node->count;
+	while (pos > 0 && _key < node->keys()[pos - 1]) {
+		this->stats_compare();
+		pos--;
+	}
+	emplaceAt(node, pos, std::move(_key), std::move(_val));
+}
+
+template<typename key, typename val, int Capacity, typename Stats>
+bool Unrolled_List<key, val, Capacity, Stats>::erase(const key& _key) {
+	this->stats_begin(STATS_ERASE);
+	Node* prev;
+	Node* node = findNode(_key, &prev);
+	int i = node ? indexOf(node, _key) : -1;
+	if (i < 0)
+		return false;
+
+	node->keys()[i].~key();
+	node->vals()[i].~val();
+	node->closeAt(i);
+	node->count--;
+	size--;
+
+	if (node->count == 0) {
+		(prev ? prev->next : head) = node->next;
+		if (tail == node)
+			tail = prev;
+		delete node;
+		this->stats_free();
+	}
+	else if (node->count < Capacity / 2 && node->next && node->count + node->next->count <= Capacity) {
+		Node* next = node->next;
+		for (int j = 0; j < next->count; j++)
+			next->moveTo(j, node, node->count + j);
+		node->count += next->count;
+		next->count = 0;
+		node->next = next->next;
+		if (tail == next)
+			tail = node;
+		delete next;
+		this->stats_free();
+	}
+	return true;
+}
+
+#endif
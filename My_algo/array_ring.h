@@ -0,0 +1,389 @@
+#ifndef ARRAY_RING_H
+#define ARRAY_RING_H
+#include <cstddef>
+#include <iostream>
+#include <new>
+#include <utility>
+#include "container_stats.h"
+
+//bi_ring for workloads that only touch the ends of the ring: the elements live in one array whose
+//capacity is a power of two, positions wrap with a mask and the array doubles when it is full.
+//Same iterator/const_iterator and push/pop API as bi_ring, but no insert or erase in the middle,
+//and growing invalidates iterators (bi_ring's stay valid).
+//Stats is an instrumentation policy from container_stats.h; allocations count array growths
+template <typename Key, typename Info, typename Stats = no_stats>
+class array_ring : private Stats {
+private:
+    struct Entry {
+        Key key;
+        Info info;
+    };
+    Entry* slots;
+    size_t mask; //capacity - 1, capacity is 0 or a power of two
+    size_t head; //slot of the first element
+    int size;
+
+    static const size_t MIN_CAPACITY = 8;
+
+    size_t capacity() const {
+        return slots == nullptr ? 0 : mask + 1;
+    }
+    size_t slot(size_t pos) const { //slot of the element pos places after head
+        return (head + pos) & mask;
+    }
+    size_t last() const {
+        return slot(size - 1);
+    }
+    Entry* allocate(size_t cap);
+    void adopt(Entry* fresh, size_t cap);
+    void grow(size_t cap) {
+        adopt(allocate(cap), cap);
+    }
+    size_t grown_capacity() const {
+        return capacity() == 0 ? MIN_CAPACITY : 2 * capacity();
+    }
+    void release();
+
+    template <typename K, typename I>
+    size_t link_front(K&& k, I&& i);
+    template <typename K, typename I>
+    size_t link_back(K&& k, I&& i);
+public:
+    class iterator {
+    private:
+        array_ring* r;
+        size_t i;
+    public:
+        iterator(array_ring* r, size_t i) : r(r), i(i) {}
+        iterator(const iterator& it) : r(it.r), i(it.i) {}
+        iterator& operator=(const iterator& it) {
+            r = it.r;
+            i = it.i;
+            return *this;
+        }
+        iterator& operator++() {
+            i = i == r->last() ? r->head : (i + 1) & r->mask;
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+        iterator& operator--() {
+            i = i == r->head ? r->last() : (i - 1) & r->mask;
+            return *this;
+        }
+        iterator operator--(int) {
+            iterator tmp = *this;
+            --*this;
+            return tmp;
+        }
+        bool operator==(const iterator& it) const {
+            return r == it.r && i == it.i;
+        }
+        bool operator!=(const iterator& it) const {
+            return !(*this == it);
+        }
+        Key& key() const {
+            return r->slots[i].key;
+        }
+        Info& info() const {
+            return r->slots[i].info;
+        }
+    };
+    iterator begin() {
+        return iterator(this, head);
+    }
+    iterator end() { //last element, as in bi_ring
+        return iterator(this, empty() ? head : last());
+    }
+
+    class const_iterator {
+    private:
+        const array_ring* r;
+        size_t i;
+    public:
+        const_iterator(const array_ring* r, size_t i) : r(r), i(i) {}
+        const_iterator(const const_iterator& it) : r(it.r), i(it.i) {}
+        const_iterator& operator=(const const_iterator& it) {
+            r = it.r;
+            i = it.i;
+            return *this;
+        }
+        const_iterator& operator++() {
+            i = i == r->last() ? r->head : (i + 1) & r->mask;
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+        const_iterator& operator--() {
+            i = i == r->head ? r->last() : (i - 1) & r->mask;
+            return *this;
+        }
+        const_iterator operator--(int) {
+            const_iterator tmp = *this;
+            --*this;
+            return tmp;
+        }
+        bool operator==(const const_iterator& it) const {
+            return r == it.r && i == it.i;
+        }
+        bool operator!=(const const_iterator& it) const {
+            return !(*this == it);
+        }
+        const Key& key() const {
+            return r->slots[i].key;
+        }
+        const Info& info() const {
+            return r->slots[i].info;
+        }
+    };
+    const_iterator begin() const {
+        return const_iterator(this, head);
+    }
+    const_iterator end() const {
+        return const_iterator(this, empty() ? head : last());
+    }
+
+    using Stats::stats; //counters of the Stats policy, all zero with no_stats
+    using Stats::reset_stats;
+
+    array_ring() : slots(nullptr), mask(0), head(0), size(0) {}
+    ~array_ring() { release(); }
+    array_ring(const array_ring& ar);
+    array_ring& operator=(const array_ring& ar);
+    array_ring(array_ring&& ar) noexcept : slots(ar.slots), mask(ar.mask), head(ar.head), size(ar.size) {
+        ar.slots = nullptr;
+        ar.mask = 0;
+        ar.head = 0;
+        ar.size = 0;
+    }
+    array_ring& operator=(array_ring&& ar) noexcept;
+
+    bool empty() const {
+        return size == 0;
+    }
+    void print() const;
+    void clear();
+    int get_size() const {
+        return size;
+    }
+    //makes room for n elements without further growth
+    void reserve(size_t n);
+
+    iterator push_front(const Key& k, const Info& i);
+    iterator push_front(Key&& k, Info&& i);
+    iterator pop_front();
+    iterator push_back(const Key& k, const Info& i);
+    iterator push_back(Key&& k, Info&& i);
+    iterator pop_back();
+
+    template <typename K, typename I>
+    iterator emplace_front(K&& k, I&& i) { this->stats_begin(STATS_INSERT); return iterator(this, link_front(std::forward<K>(k), std::forward<I>(i))); }
+    template <typename K, typename I>
+    iterator emplace_back(K&& k, I&& i) { this->stats_begin(STATS_INSERT); return iterator(this, link_back(std::forward<K>(k), std::forward<I>(i))); }
+};
+
+//***********************Memory***********************//
+template<typename Key, typename Info, typename Stats>
+typename array_ring<Key, Info, Stats>::Entry* array_ring<Key, Info, Stats>::allocate(size_t cap) {
+    Entry* fresh = static_cast<Entry*>(::operator new(cap * sizeof(Entry)));
+    this->stats_allocate();
+    return fresh;
+}
+
+//moves the elements to fresh, an array of cap slots, the first one to slot 0
+template<typename Key, typename Info, typename Stats>
+void array_ring<Key, Info, Stats>::adopt(Entry* fresh, size_t cap) {
+    for (int pos = 0; pos < size; pos++) {
+        Entry& e = slots[slot(pos)];
+        new (fresh + pos) Entry{ std::move(e.key), std::move(e.info) };
+        e.~Entry();
+    }
+    if (slots != nullptr) {
+        ::operator delete(slots);
+        this->stats_free();
+    }
+    slots = fresh;
+    mask = cap - 1;
+    head = 0;
+}
+
+template<typename Key, typename Info, typename Stats>
+void array_ring<Key, Info, Stats>::reserve(size_t n) {
+    if (n <= capacity()) {
+        return;
+    }
+    size_t cap = MIN_CAPACITY;
+    while (cap < n) {
+        cap *= 2;
+    }
+    grow(cap);
+}
+
+template<typename Key, typename Info, typename Stats>
+void array_ring<Key, Info, Stats>::clear() {
+    for (int pos = 0; pos < size; pos++) {
+        slots[slot(pos)].~Entry();
+    }
+    head = 0;
+    size = 0;
+}
+
+template<typename Key, typename Info, typename Stats>
+void array_ring<Key, Info, Stats>::release() {
+    clear();
+    if (slots != nullptr) {
+        ::operator delete(slots);
+        this->stats_free();
+    }
+    slots = nullptr;
+    mask = 0;
+}
+
+template<typename Key, typename Info, typename Stats>
+array_ring<Key, Info, Stats>::array_ring(const array_ring& ar) : slots(nullptr), mask(0), head(0), size(0) {
+    reserve(ar.size);
+    for (int pos = 0; pos < ar.size; pos++) {
+        const Entry& e = ar.slots[ar.slot(pos)];
+        link_back(e.key, e.info);
+    }
+}
+
+template<typename Key, typename Info, typename Stats>
+array_ring<Key, Info, Stats>& array_ring<Key, Info, Stats>::operator=(const array_ring& ar) {
+    if (this == &ar) {
+        return *this;
+    }
+    clear();
+    reserve(ar.size);
+    for (int pos = 0; pos < ar.size; pos++) {
+        const Entry& e = ar.slots[ar.slot(pos)];
+        link_back(e.key, e.info);
+    }
+    return *this;
+}
+
+template<typename Key, typename Info, typename Stats>
+array_ring<Key, Info, Stats>& array_ring<Key, Info, Stats>::operator=(array_ring&& ar) noexcept {
+    if (this == &ar) {
+        return *this;
+    }
+    release();
+    slots = ar.slots;
+    mask = ar.mask;
+    head = ar.head;
+    size = ar.size;
+    ar.slots = nullptr;
+    ar.mask = 0;
+    ar.head = 0;
+    ar.size = 0;
+    return *this;
+}
+
+//***********************Push and Pop***********************//
+//k and i may refer to an element of this ring, so when it is full the new element is built in the
+//grown array first and only then are the old ones moved over
+template<typename Key, typename Info, typename Stats>
+template<typename K, typename I>
+size_t array_ring<Key, Info, Stats>::link_front(K&& k, I&& i) {
+    if (static_cast<size_t>(size) == capacity()) {
+        size_t cap = grown_capacity();
+        Entry* fresh = allocate(cap);
+        new (fresh + cap - 1) Entry{ std::forward<K>(k), std::forward<I>(i) };
+        adopt(fresh, cap);
+        head = cap - 1;
+        size++;
+        return head;
+    }
+    size_t s = (head - 1) & mask;
+    new (slots + s) Entry{ std::forward<K>(k), std::forward<I>(i) };
+    head = s;
+    size++;
+    return s;
+}
+
+template<typename Key, typename Info, typename Stats>
+template<typename K, typename I>
+size_t array_ring<Key, Info, Stats>::link_back(K&& k, I&& i) {
+    if (static_cast<size_t>(size) == capacity()) {
+        size_t cap = grown_capacity();
+        Entry* fresh = allocate(cap);
+        new (fresh + size) Entry{ std::forward<K>(k), std::forward<I>(i) };
+        adopt(fresh, cap);
+        return static_cast<size_t>(size++);
+    }
+    size_t s = slot(size);
+    new (slots + s) Entry{ std::forward<K>(k), std::forward<I>(i) };
+    size++;
+    return s;
+}
+
+template<typename Key, typename Info, typename Stats>
+typename array_ring<Key, Info, Stats>::iterator array_ring<Key, Info, Stats>::push_front(const Key& k, const Info& i) {
+    this->stats_begin(STATS_INSERT);
+    return iterator(this, link_front(k, i));
+}
+
+template<typename Key, typename Info, typename Stats>
+typename array_ring<Key, Info, Stats>::iterator array_ring<Key, Info, Stats>::push_front(Key&& k, Info&& i) {
+    this->stats_begin(STATS_INSERT);
+    return iterator(this, link_front(std::move(k), std::move(i)));
+}
+
+template<typename Key, typename Info, typename Stats>
+typename array_ring<Key, Info, Stats>::iterator array_ring<Key, Info, Stats>::push_back(const Key& k, const Info& i) {
+    this->stats_begin(STATS_INSERT);
+    return iterator(this, link_back(k, i));
+}
+
+template<typename Key, typename Info, typename Stats>
+typename array_ring<Key, Info, Stats>::iterator array_ring<Key, Info, Stats>::push_back(Key&& k, Info&& i) {
+    this->stats_begin(STATS_INSERT);
+    return iterator(this, link_back(std::move(k), std::move(i)));
+}
+
+//both pops return the new first element, like bi_ring
+template<typename Key, typename Info, typename Stats>
+typename array_ring<Key, Info, Stats>::iterator array_ring<Key, Info, Stats>::pop_front() {
+    this->stats_begin(STATS_ERASE);
+    if (empty()) {
+        return begin();
+    }
+    slots[head].~Entry();
+    head = (head + 1) & mask;
+    size--;
+    return begin();
+}
+
+template<typename Key, typename Info, typename Stats>
+typename array_ring<Key, Info, Stats>::iterator array_ring<Key, Info, Stats>::pop_back() {
+    this->stats_begin(STATS_ERASE);
+    if (empty()) {
+        return begin();
+    }
+    slots[last()].~Entry();
+    size--;
+    return begin();
+}
+
+//***********************Printing***********************//
+template<typename Key, typename Info, typename Stats>
+void array_ring<Key, Info, Stats>::print() const {
+    if (empty()) {
+        std::cout << "Empty list\n" << std::endl;
+        return;
+    }
+    std::cout << "Start printing" << std::endl;
+    for (int pos = 0; pos < size; pos++) {
+        const Entry& e = slots[slot(pos)];
+        std::cout << "Key[" << e.key << "] => " << e.info << std::endl;
+    }
+    std::cout << "End printing\n" << std::endl;
+}
+
+#endif
@@ -1,38 +1,120 @@
 #ifndef LAB3_AVLTREE__AVLTREE_H
 #define LAB3_AVLTREE__AVLTREE_H
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <fstream>
 #include <vector>
+#include <utility>
+#include <queue>
+#include <cassert>
+#include <cctype>
+#include <future>
+#include <iterator>
+#include <thread>
+#include <type_traits>
+#include "node_allocator.h"
+#include "frozen_tree.h"
+#include "container_stats.h"
 #define DISTANCE 10
 
+//define AVLTREE_VALIDATE to re-check the whole tree after every update (debug builds only)
+#if defined(AVLTREE_VALIDATE) && !defined(NDEBUG)
+#define AVLTREE_CHECK(cond) assert(cond)
+#else
+#define AVLTREE_CHECK(cond) ((void)0)
+#endif
 
-template <typename Key, typename Info>
-class avltree {
+
+//top-K augmentation policies for avltree. track_max_info keeps a pointer to the node with the
+//greatest info in every subtree, so max_info() is O(k log n), at the price of two info comparisons
+//per node update and Info needing operator>. no_max_info, the default, keeps nothing and
+//max_info() scans the whole tree
+struct no_max_info {
+    static constexpr bool enabled = false;
+};
+
+struct track_max_info {
+    static constexpr bool enabled = true;
+};
+
+//the max_node field of a node, present only when it is tracked
+template <typename Node, bool tracked>
+struct avl_max_slot {
+    Node* max_node; //node with the greatest info in this subtree
+    explicit avl_max_slot(Node* self) : max_node(self) {}
+};
+
+template <typename Node>
+struct avl_max_slot<Node, false> {
+    explicit avl_max_slot(Node*) {}
+};
+
+
+//Allocator is a node allocation policy from node_allocator.h;
+//pass pool_allocator to reuse freed nodes and make clear() release whole slabs.
+//Stats is an instrumentation policy from container_stats.h, e.g. counting_stats.
+//MaxInfo is no_max_info or track_max_info, see above
+template <typename Key, typename Info, template <typename> class Allocator = heap_allocator, typename Stats = no_stats, typename MaxInfo = no_max_info>
+class avltree : private Stats {
 private:
-    struct Node {
+    struct Node : avl_max_slot<Node, MaxInfo::enabled> {
         int height;
         Key key;
         Info info;
         Node* left;
         Node* right;
+
+        template <typename K, typename... Args>
+        Node(K&& k, Args&&... args)
+            : avl_max_slot<Node, MaxInfo::enabled>(this), height(0), key(std::forward<K>(k)),
+            info(std::forward<Args>(args)...), left(nullptr), right(nullptr) {}
     };
+    //an AVL tree of height h has at least fib(h + 3) - 1 nodes, so no real tree gets deeper than this
+    static const int MAX_DEPTH = 96;
+
     Node* root;
+    Allocator<Node> alloc;
+    bool max_stale; //infos may have changed behind the tree's back (operator[]), maxima are not trusted
+
+    template <typename K, typename... Args>
+    Node* create_node(K&& key, Args&&... args) {
+        this->stats_allocate();
+        return new (alloc.allocate()) Node(std::forward<K>(key), std::forward<Args>(args)...);
+    }
+
+    void destroy_node(Node* node) {
+        this->stats_free();
+        node->~Node();
+        alloc.deallocate(node);
+    }
 
-    int height(Node* node) {
+    int height(Node* node) const {
         if (node == nullptr) //node without child has height of -1
             return -1;
-        else {
-            int lheight = height(node->left);
-            int rheight = height(node->right);
-            if (lheight > rheight)
-                return (lheight + 1);
-            else
-                return (rheight + 1);
-        }
+        else
+            return node->height;
+    }
+
+    //recomputes the cached height and, if tracked, the subtree maximum from the children
+    void updateNode(Node* node) const {
+        int lheight = height(node->left);
+        int rheight = height(node->right);
+        node->height = (lheight > rheight ? lheight : rheight) + 1;
+        update_max(node, std::integral_constant<bool, MaxInfo::enabled>());
+    }
+
+    //only the overload in use is instantiated, so untracked trees never compare infos
+    void update_max(Node*, std::false_type) const {}
+    void update_max(Node* node, std::true_type) const {
+        node->max_node = node;
+        if (node->left != nullptr && node->left->max_node->info > node->max_node->info)
+            node->max_node = node->left->max_node;
+        if (node->right != nullptr && node->right->max_node->info > node->max_node->info)
+            node->max_node = node->right->max_node;
     }
 
-    int getBalanceFactor(Node* node) { //balance factor = left subtree - right subtree
+    int getBalanceFactor(Node* node) const { //balance factor = left subtree - right subtree
         if (node == nullptr)
             return -1;
         else
@@ -40,149 +122,386 @@ private:
     }
 
     Node* rightRotation(Node* x) {
+        this->stats_rotate();
         Node* temp = x->left;
-        if (x == root) {
-            root = temp;
-        }
         x->left = temp->right;
         temp->right = x;
+        updateNode(x);
+        updateNode(temp);
         return temp;
     }
 
     Node* leftRotation(Node* x) {
+        this->stats_rotate();
         Node* temp = x->right;
-        if (x == root) {
-            root = temp;
-        }
         x->right = temp->left;
         temp->left = x;
+        updateNode(x);
+        updateNode(temp);
         return temp;
     }
 
-    Node* insert(Node*& r, Node* new_node) {
-        if (r == nullptr) {
-            return new_node;
-        }
-        if (new_node->key < r->key)
-            r->left = insert(r->left, new_node);
-
-        else if (new_node->key > r->key)
-            r->right = insert(r->right, new_node);
-        else {
-            std::cout << "No duplicates are allowed!" << std::endl;
-            return r;
-        }
-
+    Node* rebalance(Node* r) {
+        updateNode(r);
         int bf = getBalanceFactor(r);
-        if (bf > 1 && new_node->key < r->left->key)
-            return rightRotation(r);
-        else if (bf < -1 && new_node->key > r->right->key)
-            return leftRotation(r);
-        else if (bf > 1 && new_node->key > r->left->key) {
-            r->left = leftRotation(r->left);
+        if (bf > 1) {
+            if (getBalanceFactor(r->left) < 0)
+                r->left = leftRotation(r->left);
             return rightRotation(r);
         }
-        else if (bf < -1 && new_node->key < r->right->key) {
-            r->right = rightRotation(r->right);
+        else if (bf < -1) {
+            if (getBalanceFactor(r->right) > 0)
+                r->right = rightRotation(r->right);
             return leftRotation(r);
         }
         return r;
     }
 
-    Node* deleteNode(Node*& r, Key key) {
+    //descends once, recording the child links it passes; returns the link that
+    //holds key, or the empty link where key belongs
+    Node** find_link(const Key& key, Node** path[], int& depth) {
+        Node** link = &root;
+        depth = 0;
+        while (*link != nullptr && !((*link)->key == key)) {
+            this->stats_visit();
+            this->stats_compare(2);
+            path[depth++] = link;
+            link = key < (*link)->key ? &(*link)->left : &(*link)->right;
+        }
+        if (*link != nullptr) {
+            this->stats_visit();
+            this->stats_compare();
+        }
+        return link;
+    }
 
-        if (r == nullptr)
+    //one descent; builds the info from args only if key is missing
+    template <typename K, typename... Args>
+    Node* emplace_node(K&& key, bool& created, Args&&... args) {
+        this->stats_begin(STATS_INSERT);
+        Node** path[MAX_DEPTH];
+        int depth;
+        Node** link = find_link(key, path, depth);
+        created = *link == nullptr;
+        if (created) {
+            *link = create_node(std::forward<K>(key), std::forward<Args>(args)...);
+            Node* r = *link;
+            rebalance_path(path, depth);
+            AVLTREE_CHECK(validate());
             return r;
-        if (key < r->key)
-            r->left = deleteNode(r->left, key);
-        else if (key > r->key)
-            r->right = deleteNode(r->right, key);
-        else {
-            if (r->left == nullptr) {
-                Node* temp = r->right;
-                delete r;
-                return temp;
+        }
+        return *link;
+    }
+
+    //walks back up a recorded root-to-node path of child links, fixing heights,
+    //tracked subtree maxima and rotating where needed
+    void rebalance_path(Node** path[], int depth) {
+        while (depth > 0) {
+            Node** link = path[--depth];
+            *link = rebalance(*link);
+        }
+    }
+
+    //returns the height of the subtree, or -2 if any AVL/BST invariant is broken
+    int validate(Node* r, const Key* low, const Key* high) const {
+        if (r == nullptr)
+            return -1;
+        if ((low != nullptr && !(*low < r->key)) || (high != nullptr && !(r->key < *high)))
+            return -2;
+        int lheight = validate(r->left, low, &r->key);
+        int rheight = validate(r->right, &r->key, high);
+        if (lheight == -2 || rheight == -2)
+            return -2;
+        int h = (lheight > rheight ? lheight : rheight) + 1;
+        if (r->height != h || lheight - rheight > 1 || rheight - lheight > 1)
+            return -2;
+        return h;
+    }
+
+    Node* search(Node* r, const Key& key) const {
+        while (r != nullptr && !(r->key == key)) {
+            this->stats_visit();
+            this->stats_compare(2);
+            r = key < r->key ? r->left : r->right;
+        }
+        if (r != nullptr) {
+            this->stats_visit();
+            this->stats_compare();
+        }
+        return r;
+    }
+
+    //rotates left children up until the current node has none, then frees it and
+    //moves right, so no stack is needed
+    Node* clear(Node*& r) {
+        Node* node = r;
+        while (node != nullptr) {
+            if (node->left != nullptr) {
+                Node* temp = node->left;
+                node->left = temp->right;
+                temp->right = node;
+                node = temp;
             }
-            else if (r->right == nullptr) {
+            else {
+                Node* temp = node->right;
+                destroy_node(node);
+                node = temp;
+            }
+        }
+        r = nullptr;
+        return r;
+    }
+
+    //runs destructors only, the storage is handed back by alloc.reset()
+    void destroy_subtree(Node* r) {
+        while (r != nullptr) {
+            if (r->left != nullptr) {
                 Node* temp = r->left;
-                delete r;
-                return temp;
+                r->left = temp->right;
+                temp->right = r;
+                r = temp;
             }
             else {
                 Node* temp = r->right;
-                while (temp->left != nullptr) //finds the most left node of the right subtree of r
-                    temp = temp->left;
-                r->key = temp->key;
-                r->info = temp->info;
-                r->right = deleteNode(r->right, temp->key);
+                r->~Node();
+                r = temp;
             }
+        }
+    }
 
+    Node* copy_tree(Node* r) {
+        Node* new_root = nullptr;
+        std::vector<std::pair<Node*, Node**>> stack; //source node, link to fill in the copy
+        stack.push_back(std::make_pair(r, &new_root));
+        while (!stack.empty()) {
+            Node* src = stack.back().first;
+            Node** link = stack.back().second;
+            stack.pop_back();
+            if (src == nullptr)
+                continue;
+            Node* new_node = create_node(src->key, src->info);
+            new_node->height = src->height;
+            *link = new_node;
+            stack.push_back(std::make_pair(src->right, &new_node->right));
+            stack.push_back(std::make_pair(src->left, &new_node->left));
         }
+        if (MaxInfo::enabled)
+            refresh_max(new_root); //max_node pointers must point into the copy
+        return new_root;
+    }
 
-        int bf = getBalanceFactor(r);
-        if (bf > 1 && getBalanceFactor(r->left) >= 0)
-            return rightRotation(r);
-        else if (bf > 1 && getBalanceFactor(r->left) < 0) {
-            r->left = leftRotation(r->left);
-            return rightRotation(r);
+    //recomputes every max_node in postorder
+    void refresh_max(Node* r) const {
+        std::vector<std::pair<Node*, bool>> stack; //node, children already done
+        if (r != nullptr)
+            stack.push_back(std::make_pair(r, false));
+        while (!stack.empty()) {
+            Node* node = stack.back().first;
+            if (stack.back().second) {
+                stack.pop_back();
+                updateNode(node);
+                continue;
+            }
+            stack.back().second = true;
+            if (node->right != nullptr)
+                stack.push_back(std::make_pair(node->right, false));
+            if (node->left != nullptr)
+                stack.push_back(std::make_pair(node->left, false));
         }
-        else if (bf < -1 && getBalanceFactor(r->right) <= 0)
-            return leftRotation(r);
-        else if (bf < -1 && getBalanceFactor(r->right) > 0) {
-            r->right = rightRotation(r->right);
-            return leftRotation(r);
+    }
+
+    //*************** join-based primitives, all O(log n) unless noted ***************//
+
+    Node* make(Node* l, Node* k, Node* r) {
+        k->left = l;
+        k->right = r;
+        updateNode(k);
+        return k;
+    }
+
+    //attaches k and r below the right spine of l, which is more than one level taller
+    Node* join_right(Node* l, Node* k, Node* r) {
+        if (height(l->right) <= height(r) + 1)
+            l->right = make(l->right, k, r);
+        else
+            l->right = join_right(l->right, k, r);
+        return rebalance(l);
+    }
+
+    Node* join_left(Node* l, Node* k, Node* r) {
+        if (height(r->left) <= height(l) + 1)
+            r->left = make(l, k, r->left);
+        else
+            r->left = join_left(l, k, r->left);
+        return rebalance(r);
+    }
+
+    //every key in l < k->key < every key in r; costs O(|height(l) - height(r)| + 1)
+    Node* join(Node* l, Node* k, Node* r) {
+        if (height(l) > height(r) + 1)
+            return join_right(l, k, r);
+        if (height(r) > height(l) + 1)
+            return join_left(l, k, r);
+        return make(l, k, r);
+    }
+
+    Node* split_last(Node* t, Node*& last) {
+        if (t->right == nullptr) {
+            last = t;
+            return t->left;
         }
-        return r;
+        Node* r = split_last(t->right, last);
+        return join(t->left, t, r);
     }
 
-    Node* search(Node* r, Key key) const {
-        if (r == nullptr)
-            return nullptr;
-        if (r->key == key)
+    Node* join2(Node* l, Node* r) {
+        if (l == nullptr)
             return r;
-        if (r->key > key)
-            return search(r->left, key);
-        else
-            return search(r->right, key);
+        Node* k;
+        Node* rest = split_last(l, k);
+        return join(rest, k, r);
     }
 
-    Node* clear(Node*& r) {
-        if (r != nullptr) {
-            clear(r->left);
-            clear(r->right);
-            delete r;
-            r = nullptr;
+    //splits t into keys < key and keys > key; returns the detached node holding key, if any
+    Node* split(Node* t, const Key& key, Node*& l, Node*& r) {
+        if (t == nullptr) {
+            l = r = nullptr;
+            return nullptr;
         }
-        return r;
+        Node* tl = t->left;
+        Node* tr = t->right;
+        this->stats_visit();
+        this->stats_compare(2);
+        if (t->key == key) {
+            l = tl;
+            r = tr;
+            make(nullptr, t, nullptr);
+            return t;
+        }
+        Node* found;
+        Node* m;
+        if (key < t->key) {
+            found = split(tl, key, l, m);
+            r = join(m, t, tr);
+        }
+        else {
+            found = split(tr, key, m, r);
+            l = join(tl, t, m);
+        }
+        return found;
     }
 
-    Node* copy_tree(Node* r) {
-        Node* new_node = new Node;
-        if (r == nullptr)
-            return (new_node = nullptr);
+    //builds a perfectly balanced tree out of the next n entries of a sorted range, O(n)
+    template <typename It>
+    Node* build(It& it, size_t n) {
+        if (n == 0)
+            return nullptr;
+        Node* l = build(it, n / 2);
+        Node* k = create_node(it->first, it->second);
+        ++it;
+        Node* r = build(it, n - n / 2 - 1);
+        return make(l, k, r);
+    }
+
+    //runs both halves of a divide step, the first one on another thread while depth lasts
+    template <typename F1, typename F2>
+    static void fork(int par_depth, F1 f1, F2 f2) {
+        if (par_depth > 0) {
+            auto first = std::async(std::launch::async, f1);
+            f2();
+            first.get();
+        }
         else {
-            new_node->key = r->key;
-            new_node->info = r->info;
-            new_node->left = copy_tree(r->left);
-            new_node->right = copy_tree(r->right);
-            return new_node;
+            f1();
+            f2();
         }
+    }
 
+    //the set operations consume both trees; keys present in both keep t1's node
+    Node* unite(Node* t1, Node* t2, int par_depth) {
+        if (t1 == nullptr)
+            return t2;
+        if (t2 == nullptr)
+            return t1;
+        Node* l2;
+        Node* r2;
+        Node* dup = split(t2, t1->key, l2, r2);
+        if (dup != nullptr)
+            destroy_node(dup);
+        Node* l1 = t1->left;
+        Node* r1 = t1->right;
+        Node* l;
+        Node* r;
+        fork(par_depth, [&]() { l = unite(l1, l2, par_depth - 1); },
+            [&]() { r = unite(r1, r2, par_depth - 1); });
+        return join(l, t1, r);
     }
 
-    Node* max_info(Node* r) const {
-        if (r == nullptr)
+    Node* intersect(Node* t1, Node* t2, int par_depth) {
+        if (t1 == nullptr || t2 == nullptr) {
+            clear(t1);
+            clear(t2);
             return nullptr;
-        Node* max = r;
-        Node* temp = max_info(r->left);
-        if (temp != nullptr && temp->info > max->info)
-            max = temp;
-        temp = max_info(r->right);
-        if (temp != nullptr && temp->info > max->info)
-            max = temp;
-        return max;
+        }
+        Node* l2;
+        Node* r2;
+        Node* dup = split(t2, t1->key, l2, r2);
+        Node* l1 = t1->left;
+        Node* r1 = t1->right;
+        Node* l;
+        Node* r;
+        fork(par_depth, [&]() { l = intersect(l1, l2, par_depth - 1); },
+            [&]() { r = intersect(r1, r2, par_depth - 1); });
+        if (dup != nullptr) {
+            destroy_node(dup);
+            return join(l, t1, r);
+        }
+        destroy_node(t1);
+        return join2(l, r);
     }
 
+    Node* subtract(Node* t1, Node* t2, int par_depth) {
+        if (t1 == nullptr || t2 == nullptr) {
+            clear(t2);
+            return t1;
+        }
+        Node* l1;
+        Node* r1;
+        Node* dup = split(t1, t2->key, l1, r1);
+        if (dup != nullptr)
+            destroy_node(dup);
+        Node* l2 = t2->left;
+        Node* r2 = t2->right;
+        destroy_node(t2);
+        Node* l;
+        Node* r;
+        fork(par_depth, [&]() { l = subtract(l1, l2, par_depth - 1); },
+            [&]() { r = subtract(r1, r2, par_depth - 1); });
+        return join2(l, r);
+    }
+
+    //takes over a subtree owned by from; nodes of a stateful allocator can't change
+    //owner, so they are copied into this tree's allocator instead, O(size of t)
+    Node* adopt(avltree& from, Node* t) {
+        if (Allocator<Node>::stateless || &from == this)
+            return t;
+        Node* copy = copy_tree(t);
+        from.clear(t);
+        return copy;
+    }
+
+    int parallel_depth(bool parallel) const {
+        if (!parallel || !Allocator<Node>::stateless || Stats::enabled) //neither a pool nor the counters are thread safe
+            return 0;
+        int depth = 0;
+        for (unsigned n = std::thread::hardware_concurrency(); n > 1; n /= 2)
+            depth++;
+        return depth + 1;
+    }
+
+    std::vector<std::pair<Key, Info>> max_info(unsigned cnt, std::false_type) const;
+    std::vector<std::pair<Key, Info>> max_info(unsigned cnt, std::true_type) const;
+
     void display(Node* r, int distance) const {
         if (r == nullptr)
             return;
@@ -204,152 +523,735 @@ private:
     }
 
 public:
+    using Stats::stats; //counters of the Stats policy, all zero with no_stats
+    using Stats::reset_stats;
+
+    //in-order, bidirectional; keeps the path from the root, so ++ and -- are amortized O(1).
+    //infos are read-only here, write them through update() or increment()
+    class const_iterator {
+    private:
+        const avltree* tree;
+        Node* path[MAX_DEPTH];
+        int depth; //path[depth - 1] is the current node, 0 means end()
+
+        void push_leftmost(Node* n) {
+            for (; n != nullptr; n = n->left)
+                path[depth++] = n;
+        }
+        void push_rightmost(Node* n) {
+            for (; n != nullptr; n = n->right)
+                path[depth++] = n;
+        }
+        Node* current() const {
+            return depth == 0 ? nullptr : path[depth - 1];
+        }
+
+        friend class avltree;
+    public:
+        const_iterator() : tree(nullptr), depth(0) {}
+        explicit const_iterator(const avltree* t) : tree(t), depth(0) {}
+        const_iterator(const const_iterator& it) : tree(it.tree), depth(it.depth) {
+            for (int i = 0; i < depth; i++)
+                path[i] = it.path[i];
+        }
+        const_iterator& operator=(const const_iterator& it) {
+            tree = it.tree;
+            depth = it.depth;
+            for (int i = 0; i < depth; i++)
+                path[i] = it.path[i];
+            return *this;
+        }
+        const_iterator& operator++() {
+            Node* n = path[depth - 1];
+            if (n->right != nullptr)
+                push_leftmost(n->right);
+            else {
+                Node* child;
+                do {
+                    child = path[--depth];
+                } while (depth > 0 && path[depth - 1]->right == child);
+            }
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+        const_iterator& operator--() { //--end() is the last element
+            if (depth == 0) {
+                push_rightmost(tree->root);
+                return *this;
+            }
+            Node* n = path[depth - 1];
+            if (n->left != nullptr)
+                push_rightmost(n->left);
+            else {
+                Node* child;
+                do {
+                    child = path[--depth];
+                } while (depth > 0 && path[depth - 1]->left == child);
+            }
+            return *this;
+        }
+        const_iterator operator--(int) {
+            const_iterator tmp = *this;
+            --*this;
+            return tmp;
+        }
+        bool operator==(const const_iterator& it) const {
+            return current() == it.current();
+        }
+        bool operator!=(const const_iterator& it) const {
+            return current() != it.current();
+        }
+        const Key& key() const {
+            return path[depth - 1]->key;
+        }
+        const Info& info() const {
+            return path[depth - 1]->info;
+        }
+    };
+    typedef const_iterator iterator;
+
+    const_iterator begin() const {
+        const_iterator it(this);
+        it.push_leftmost(root);
+        return it;
+    }
+    const_iterator end() const {
+        return const_iterator(this);
+    }
+
+    const_iterator lower_bound(const Key& key) const; //first key >= key
+    const_iterator upper_bound(const Key& key) const; //first key > key
+    std::pair<const_iterator, const_iterator> equal_range(const Key& key) const;
+    //calls visit(key, info) for every key in [low, high) in order, O(log n + k)
+    template <typename F>
+    void range(const Key& low, const Key& high, F visit) const;
+
     avltree();
     ~avltree();
     avltree(const avltree& rhs);
     avltree& operator=(const avltree& rhs);
+    avltree(avltree&& rhs) noexcept;
+    avltree& operator=(avltree&& rhs) noexcept;
+    template <typename It>
+    avltree(It first, It last); //O(n) build from key/info pairs sorted by key without duplicates
 
     void insert(Key key, Info info);
+    template <typename... Args>
+    bool emplace(const Key& key, Args&&... args); //builds the info in place, false if key exists
+    template <typename... Args>
+    bool emplace(Key&& key, Args&&... args); //moves key into a new node
     bool isEmpty() const;
-    bool search(Key key) const;
-    void deleteNode(Key key);
+    bool search(const Key& key) const;
+    void deleteNode(const Key& key);
     void clear();
     void display() const;
     void postOrder() const;
+    bool validate() const; //checks cached heights, balance and key order
+    bool update(const Key& key, Info info); //replaces the info of an existing key
+    Info& find_or_emplace(const Key& key, Info info = Info()); //inserts info only if key is missing
+    const Info& increment(const Key& key, const Info& delta); //adds delta, starting from Info() for a new key
+    void merge(const avltree& other); //adds every info of other to the same key here
 
-    Info& operator[](Key key);
+    //split/join based operations; they take the nodes of other and leave it empty.
+    //parallel recursion is only used with a stateless allocator
+    avltree split(const Key& key); //moves keys >= key into the returned tree
+    void join(avltree& other); //every key of other must be greater than every key here
+    void set_union(avltree& other, bool parallel = false); //keeps this tree's info for common keys
+    void set_intersection(avltree& other, bool parallel = false);
+    void set_difference(avltree& other, bool parallel = false);
+    void erase_range(const Key& low, const Key& high); //erases keys in [low, high)
+    //cnt entries with the greatest infos, greatest first. O(k log n) with track_max_info while the
+    //maxima are current, otherwise a scan of the whole tree, O(n log k). operator[] and
+    //find_or_emplace hand out writable references, so after either one the maxima are no longer
+    //trusted and every call scans until refresh_max_info(); increment() and update() keep them current
+    std::vector<std::pair<Key, Info>> max_info(unsigned cnt) const;
+    //recomputes the maxima after infos were written through references from operator[] or
+    //find_or_emplace, O(n); until then max_info() scans. Does nothing for no_max_info
+    void refresh_max_info();
+    frozen_avltree<Key, Info> freeze() const; //read-only, cache friendly snapshot
+
+    Info& operator[](const Key& key);
+    Info& operator[](Key&& key);
 };
 
-template <typename Key, typename Info>
-avltree<Key, Info>::avltree() {
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+avltree<Key, Info, Allocator, Stats, MaxInfo>::avltree() {
     root = nullptr;
+    max_stale = false;
 }
 
-template <typename Key, typename Info>
-avltree<Key, Info>::~avltree() {
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+avltree<Key, Info, Allocator, Stats, MaxInfo>::~avltree() {
     clear();
 }
 
-template <typename Key, typename Info>
-avltree<Key, Info>::avltree(const avltree& rhs) {
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+avltree<Key, Info, Allocator, Stats, MaxInfo>::avltree(const avltree& rhs) {
     this->root = copy_tree(rhs.root);
+    this->max_stale = false;
 }
 
-template <typename Key, typename Info>
-avltree<Key, Info>& avltree<Key, Info>::operator=(const avltree<Key, Info>& rhs) {
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+avltree<Key, Info, Allocator, Stats, MaxInfo>& avltree<Key, Info, Allocator, Stats, MaxInfo>::operator=(const avltree& rhs) {
     if (this != &rhs) {
         this->clear();
         Node* temp = rhs.root;
         this->root = copy_tree(temp);
+        this->max_stale = false;
+    }
+    return *this;
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+avltree<Key, Info, Allocator, Stats, MaxInfo>::avltree(avltree&& rhs) noexcept : alloc(std::move(rhs.alloc)) {
+    root = rhs.root;
+    max_stale = rhs.max_stale;
+    rhs.root = nullptr;
+    rhs.max_stale = false;
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+avltree<Key, Info, Allocator, Stats, MaxInfo>& avltree<Key, Info, Allocator, Stats, MaxInfo>::operator=(avltree&& rhs) noexcept {
+    if (this != &rhs) {
+        this->clear();
+        alloc = std::move(rhs.alloc);
+        root = rhs.root;
+        max_stale = rhs.max_stale;
+        rhs.root = nullptr;
+        rhs.max_stale = false;
     }
     return *this;
 }
 
-template <typename Key, typename Info>
-void avltree<Key, Info>::insert(Key key, Info info) {
-    Node* new_node = new Node;
-    new_node->key = key;
-    new_node->info = info;
-    new_node->left = nullptr;
-    new_node->right = nullptr;
-    new_node->height = 0;
-    if (root == nullptr) {
-        root = new_node;
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+template <typename It>
+avltree<Key, Info, Allocator, Stats, MaxInfo>::avltree(It first, It last) {
+    max_stale = false;
+    root = build(first, std::distance(first, last));
+    AVLTREE_CHECK(validate());
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+void avltree<Key, Info, Allocator, Stats, MaxInfo>::insert(Key key, Info info) {
+    this->stats_begin(STATS_INSERT);
+    Node** path[MAX_DEPTH];
+    int depth;
+    Node** link = find_link(key, path, depth);
+    if (*link != nullptr) {
+        std::cout << "No duplicates are allowed!" << std::endl;
         return;
     }
-    //    if(new_node == insert(root, new_node))
-    //        delete new_node;
-    insert(root, new_node);
+    *link = create_node(std::move(key), std::move(info));
+    rebalance_path(path, depth);
+    AVLTREE_CHECK(validate());
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+template <typename... Args>
+bool avltree<Key, Info, Allocator, Stats, MaxInfo>::emplace(const Key& key, Args&&... args) {
+    bool created;
+    emplace_node(key, created, std::forward<Args>(args)...);
+    return created;
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+template <typename... Args>
+bool avltree<Key, Info, Allocator, Stats, MaxInfo>::emplace(Key&& key, Args&&... args) {
+    bool created;
+    emplace_node(std::move(key), created, std::forward<Args>(args)...);
+    return created;
 }
 
-template <typename Key, typename Info>
-void avltree<Key, Info>::display() const {
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+void avltree<Key, Info, Allocator, Stats, MaxInfo>::display() const {
     display(root, 5);
 }
 
-template <typename Key, typename Info>
-void avltree<Key, Info>::postOrder() const {
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+void avltree<Key, Info, Allocator, Stats, MaxInfo>::postOrder() const {
     postOrder(root);
 }
 
-template <typename Key, typename Info>
-bool avltree<Key, Info>::search(Key key) const {
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+bool avltree<Key, Info, Allocator, Stats, MaxInfo>::search(const Key& key) const {
+    this->stats_begin(STATS_FIND);
     if (search(root, key) == nullptr)
         return false;
     else
         return true;
 }
 
-template <typename Key, typename Info>
-void avltree<Key, Info>::clear() {
-    clear(root);
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+void avltree<Key, Info, Allocator, Stats, MaxInfo>::clear() {
+    if (Allocator<Node>::can_reset) {
+        if (!std::is_trivially_destructible<Node>::value)
+            destroy_subtree(root);
+        root = nullptr;
+        alloc.reset();
+    }
+    else
+        clear(root);
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+void avltree<Key, Info, Allocator, Stats, MaxInfo>::deleteNode(const Key& key) {
+    this->stats_begin(STATS_ERASE);
+    Node** path[MAX_DEPTH];
+    int depth;
+    Node** link = find_link(key, path, depth);
+    Node* r = *link;
+    if (r == nullptr)
+        return;
+    if (r->left == nullptr || r->right == nullptr) {
+        *link = r->left != nullptr ? r->left : r->right;
+        destroy_node(r);
+    }
+    else {
+        path[depth++] = link;
+        Node** succ_link = &r->right;
+        while ((*succ_link)->left != nullptr) { //finds the most left node of the right subtree of r
+            this->stats_visit();
+            path[depth++] = succ_link;
+            succ_link = &(*succ_link)->left;
+        }
+        Node* temp = *succ_link;
+        r->key = std::move(temp->key);
+        r->info = std::move(temp->info);
+        *succ_link = temp->right;
+        destroy_node(temp);
+    }
+    rebalance_path(path, depth);
+    AVLTREE_CHECK(validate());
 }
 
-template <typename Key, typename Info>
-void avltree<Key, Info>::deleteNode(Key key) {
-    deleteNode(root, key);
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+bool avltree<Key, Info, Allocator, Stats, MaxInfo>::validate() const {
+    return validate(root, nullptr, nullptr) != -2;
 }
 
-template <typename Key, typename Info>
-bool avltree<Key, Info>::isEmpty() const {
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+bool avltree<Key, Info, Allocator, Stats, MaxInfo>::isEmpty() const {
     if (root == nullptr)
         return true;
     else
         return false;
 }
 
-template <typename Key, typename Info>
-Info& avltree<Key, Info>::operator[](Key key) {
-    Node* temp = search(root, key);
-    if (temp == nullptr) {
-        insert(key, Info());
-        temp = search(root, key);
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+Info& avltree<Key, Info, Allocator, Stats, MaxInfo>::operator[](const Key& key) {
+    bool created;
+    Node* r = emplace_node(key, created);
+    max_stale = true; //the caller may write through the reference
+    return r->info;
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+Info& avltree<Key, Info, Allocator, Stats, MaxInfo>::operator[](Key&& key) {
+    bool created;
+    Node* r = emplace_node(std::move(key), created);
+    max_stale = true;
+    return r->info;
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+Info& avltree<Key, Info, Allocator, Stats, MaxInfo>::find_or_emplace(const Key& key, Info info) {
+    bool created;
+    Node* r = emplace_node(key, created, std::move(info));
+    max_stale = true; //the caller may write through the reference
+    return r->info;
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+const Info& avltree<Key, Info, Allocator, Stats, MaxInfo>::increment(const Key& key, const Info& delta) {
+    this->stats_begin(STATS_INSERT);
+    Node** path[MAX_DEPTH];
+    int depth;
+    Node** link = find_link(key, path, depth);
+    Node* r = *link;
+    if (r == nullptr) {
+        r = *link = create_node(key);
+        r->info += delta;
+        rebalance_path(path, depth);
+        AVLTREE_CHECK(validate());
+        return r->info;
+    }
+    r->info += delta;
+    if (MaxInfo::enabled) {
+        updateNode(r);
+        while (depth > 0)
+            updateNode(*path[--depth]);
     }
-    return temp->info;
+    return r->info;
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+bool avltree<Key, Info, Allocator, Stats, MaxInfo>::update(const Key& key, Info info) {
+    this->stats_begin(STATS_FIND);
+    Node** path[MAX_DEPTH];
+    int depth;
+    Node** link = find_link(key, path, depth);
+    Node* r = *link;
+    if (r == nullptr)
+        return false;
+    r->info = std::move(info);
+    if (MaxInfo::enabled) {
+        updateNode(r);
+        while (depth > 0)
+            updateNode(*path[--depth]);
+    }
+    return true;
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+void avltree<Key, Info, Allocator, Stats, MaxInfo>::merge(const avltree& other) {
+    std::vector<Node*> stack;
+    if (other.root != nullptr)
+        stack.push_back(other.root);
+    while (!stack.empty()) {
+        Node* node = stack.back();
+        stack.pop_back();
+        increment(node->key, node->info);
+        if (node->right != nullptr)
+            stack.push_back(node->right);
+        if (node->left != nullptr)
+            stack.push_back(node->left);
+    }
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+avltree<Key, Info, Allocator, Stats, MaxInfo> avltree<Key, Info, Allocator, Stats, MaxInfo>::split(const Key& key) {
+    this->stats_begin(STATS_OTHER);
+    Node* l;
+    Node* r;
+    Node* found = split(root, key, l, r);
+    if (found != nullptr)
+        r = join(nullptr, found, r);
+    root = l;
+    avltree greater;
+    greater.root = greater.adopt(*this, r);
+    greater.max_stale = max_stale;
+    return greater;
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+void avltree<Key, Info, Allocator, Stats, MaxInfo>::join(avltree& other) {
+    this->stats_begin(STATS_OTHER);
+    Node* t = adopt(other, other.root);
+    other.root = nullptr;
+    root = join2(root, t);
+    max_stale = max_stale || other.max_stale;
+    AVLTREE_CHECK(validate());
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+void avltree<Key, Info, Allocator, Stats, MaxInfo>::set_union(avltree& other, bool parallel) {
+    this->stats_begin(STATS_OTHER);
+    if (&other == this)
+        return;
+    Node* t = adopt(other, other.root);
+    other.root = nullptr;
+    root = unite(root, t, parallel_depth(parallel));
+    max_stale = max_stale || other.max_stale;
+    AVLTREE_CHECK(validate());
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+void avltree<Key, Info, Allocator, Stats, MaxInfo>::set_intersection(avltree& other, bool parallel) {
+    this->stats_begin(STATS_OTHER);
+    if (&other == this)
+        return;
+    Node* t = adopt(other, other.root);
+    other.root = nullptr;
+    root = intersect(root, t, parallel_depth(parallel));
+    AVLTREE_CHECK(validate());
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+void avltree<Key, Info, Allocator, Stats, MaxInfo>::set_difference(avltree& other, bool parallel) {
+    this->stats_begin(STATS_OTHER);
+    if (&other == this) {
+        clear();
+        return;
+    }
+    Node* t = adopt(other, other.root);
+    other.root = nullptr;
+    root = subtract(root, t, parallel_depth(parallel));
+    AVLTREE_CHECK(validate());
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+void avltree<Key, Info, Allocator, Stats, MaxInfo>::erase_range(const Key& low, const Key& high) {
+    this->stats_begin(STATS_ERASE);
+    if (!(low < high))
+        return;
+    Node* l;
+    Node* m;
+    Node* mid;
+    Node* r;
+    Node* found = split(root, low, l, m);
+    if (found != nullptr)
+        destroy_node(found);
+    found = split(m, high, mid, r);
+    if (found != nullptr)
+        r = join(nullptr, found, r);
+    clear(mid);
+    root = join2(l, r);
+    AVLTREE_CHECK(validate());
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+frozen_avltree<Key, Info> avltree<Key, Info, Allocator, Stats, MaxInfo>::freeze() const {
+    std::vector<std::pair<Key, Info>> sorted;
+    std::vector<Node*> stack;
+    Node* node = root;
+    while (node != nullptr || !stack.empty()) {
+        while (node != nullptr) {
+            stack.push_back(node);
+            node = node->left;
+        }
+        node = stack.back();
+        stack.pop_back();
+        sorted.push_back(std::make_pair(node->key, node->info));
+        node = node->right;
+    }
+    return frozen_avltree<Key, Info>(std::move(sorted));
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+typename avltree<Key, Info, Allocator, Stats, MaxInfo>::const_iterator avltree<Key, Info, Allocator, Stats, MaxInfo>::lower_bound(const Key& key) const {
+    this->stats_begin(STATS_FIND);
+    const_iterator it(this);
+    int found = 0; //path length up to the last node we went left at
+    Node* node = root;
+    while (node != nullptr) {
+        this->stats_visit();
+        this->stats_compare();
+        it.path[it.depth++] = node;
+        if (node->key < key)
+            node = node->right;
+        else {
+            found = it.depth;
+            node = node->left;
+        }
+    }
+    it.depth = found;
+    return it;
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+typename avltree<Key, Info, Allocator, Stats, MaxInfo>::const_iterator avltree<Key, Info, Allocator, Stats, MaxInfo>::upper_bound(const Key& key) const {
+    this->stats_begin(STATS_FIND);
+    const_iterator it(this);
+    int found = 0;
+    Node* node = root;
+    while (node != nullptr) {
+        this->stats_visit();
+        this->stats_compare();
+        it.path[it.depth++] = node;
+        if (key < node->key) {
+            found = it.depth;
+            node = node->left;
+        }
+        else
+            node = node->right;
+    }
+    it.depth = found;
+    return it;
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+std::pair<typename avltree<Key, Info, Allocator, Stats, MaxInfo>::const_iterator, typename avltree<Key, Info, Allocator, Stats, MaxInfo>::const_iterator>
+avltree<Key, Info, Allocator, Stats, MaxInfo>::equal_range(const Key& key) const {
+    return std::make_pair(lower_bound(key), upper_bound(key));
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+template <typename F>
+void avltree<Key, Info, Allocator, Stats, MaxInfo>::range(const Key& low, const Key& high, F visit) const {
+    const_iterator last = end();
+    for (const_iterator it = lower_bound(low); it != last && it.key() < high; ++it)
+        visit(it.key(), it.info());
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+std::vector<std::pair<Key, Info>> avltree<Key, Info, Allocator, Stats, MaxInfo>::max_info(unsigned cnt) const {
+    return max_info(cnt, std::integral_constant<bool, MaxInfo::enabled>());
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+void avltree<Key, Info, Allocator, Stats, MaxInfo>::refresh_max_info() {
+    if (!MaxInfo::enabled || !max_stale)
+        return;
+    refresh_max(root);
+    max_stale = false;
+}
+
+//visits every node once, keeping the cnt greatest in a heap whose top is the smallest of them
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+std::vector<std::pair<Key, Info>> avltree<Key, Info, Allocator, Stats, MaxInfo>::max_info(unsigned cnt, std::false_type) const {
+    auto greater = [](Node* a, Node* b) { return a->info > b->info; };
+    std::priority_queue<Node*, std::vector<Node*>, decltype(greater)> best(greater);
+    std::vector<Node*> stack;
+    if (root != nullptr && cnt > 0)
+        stack.push_back(root);
+    while (!stack.empty()) {
+        Node* node = stack.back();
+        stack.pop_back();
+        if (best.size() < cnt)
+            best.push(node);
+        else if (node->info > best.top()->info) {
+            best.pop();
+            best.push(node);
+        }
+        if (node->left != nullptr)
+            stack.push_back(node->left);
+        if (node->right != nullptr)
+            stack.push_back(node->right);
+    }
+    std::vector<std::pair<Key, Info>> vec(best.size());
+    for (size_t i = vec.size(); i > 0; i--) {
+        vec[i - 1] = std::make_pair(best.top()->key, best.top()->info);
+        best.pop();
+    }
+    return vec;
+}
+
+//pops subtrees from a heap ordered by their maximum; a subtree whose root is not
+//its own maximum is split into the root and its two children, so every result
+//costs O(log n) heap operations and the tree is never copied or modified
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+std::vector<std::pair<Key, Info>> avltree<Key, Info, Allocator, Stats, MaxInfo>::max_info(unsigned cnt, std::true_type) const {
+    if (max_stale) //never repaired here: a const call may run next to others on a shared tree
+        return max_info(cnt, std::false_type());
+    struct Entry {
+        Node* node;
+        bool whole; //the whole subtree or just the node itself
+        const Info& value() const { return whole ? node->max_node->info : node->info; }
+        bool operator<(const Entry& rhs) const { return rhs.value() > value(); }
+    };
+    std::vector<std::pair<Key, Info>> vec;
+    std::priority_queue<Entry> heap;
+    if (root != nullptr)
+        heap.push(Entry{ root, true });
+    while (vec.size() < cnt && !heap.empty()) {
+        Entry top = heap.top();
+        heap.pop();
+        if (!top.whole || top.node->max_node == top.node) {
+            vec.push_back(std::make_pair(top.node->key, top.node->info));
+            if (!top.whole)
+                continue;
+        }
+        else
+            heap.push(Entry{ top.node, false });
+        if (top.node->left != nullptr)
+            heap.push(Entry{ top.node->left, true });
+        if (top.node->right != nullptr)
+            heap.push(Entry{ top.node->right, true });
+    }
+    return vec;
 }
 
 // functions for the node class
-template <typename Key, typename Info>
-avltree<Key, Info> count_words(std::istream& is) {
-    avltree<Key, Info> tree;
+//both word counters track the subtree maxima by default, so max_info() on their result is the
+//O(k log n) top-K query; pass no_max_info to save the comparisons when no top-K is needed
+template <typename Key, typename Info, template <typename> class Allocator = heap_allocator, typename MaxInfo = track_max_info>
+avltree<Key, Info, Allocator, no_stats, MaxInfo> count_words(std::istream& is) {
+    avltree<Key, Info, Allocator, no_stats, MaxInfo> tree;
     std::string word;
 
     if (!is.good()) {
         std::cerr << "Error opening file" << std::endl;
         exit(1);
     }
-    while (!is.eof()) {
-        is >> word;
-        if (tree.search(word))
-            tree[word] = tree[word] + 1;
-        else
-            tree.insert(word, 1);
-    }
+    while (is >> word)
+        tree.increment(word, 1);
     return tree;
 }
 
-template <typename Key, typename Info>
-std::vector<std::pair<Key, Info>> maxinfo_selector(const avltree<Key, Info>& tree, unsigned cnt) {
+//reads the stream in chunks of CHUNK bytes cut at whitespace boundaries, one chunk per thread
+//at a time, and counts every chunk into that thread's own tree, so only threads chunks are held
+//in memory besides the trees; then merges the trees pairwise in parallel.
+//threads == 0 uses one thread per hardware core
+template <typename Key, typename Info, template <typename> class Allocator = heap_allocator, typename MaxInfo = track_max_info>
+avltree<Key, Info, Allocator, no_stats, MaxInfo> count_words_parallel(std::istream& is, unsigned threads = 0) {
+    if (!is.good()) {
+        std::cerr << "Error opening file" << std::endl;
+        exit(1);
+    }
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
 
+    const size_t CHUNK = 1 << 20;
+    auto is_space = [](char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; };
 
-    std::vector<std::pair<Key, Info>> vec;
-    std::pair<Key, Info> temp;
-    avltree<Key, Info> temp_tree = tree;
-    Key max;
-    for (int i = 0; i < cnt; i++) {
-        max = temp_tree.max_info();
-        temp.first = max->key;
-        temp.second = max->info;
-        temp_tree.deleteNode(max->key);
-        vec.push_back(temp);
-
-        //     temp = tree.maxinfo_selector();
-        //     vec.push_back(temp);
-        //     tree.deleteNode(temp.first);
-    }
-
-    temp_tree.clear();
-    return vec;
+    std::vector<avltree<Key, Info, Allocator, no_stats, MaxInfo>> trees(threads);
+    std::vector<std::string> chunks(threads);
+    std::string carry; //the word cut off at the end of the last chunk
+    std::vector<std::thread> workers;
+    bool more = true;
+    while (more) {
+        unsigned used = 0;
+        for (; used < threads && more; used++) {
+            std::string& chunk = chunks[used];
+            chunk.swap(carry);
+            carry.clear();
+            size_t old = chunk.size();
+            chunk.resize(old + CHUNK);
+            is.read(&chunk[old], CHUNK);
+            chunk.resize(old + static_cast<size_t>(is.gcount()));
+            more = static_cast<bool>(is);
+            if (more) { //never cut a word in half
+                size_t cut = chunk.size();
+                while (cut > 0 && !is_space(chunk[cut - 1]))
+                    cut--;
+                carry.assign(chunk, cut, std::string::npos);
+                chunk.resize(cut);
+            }
+        }
+
+        workers.clear();
+        for (unsigned i = 0; i < used; i++) {
+            workers.push_back(std::thread([&, i]() {
+                const std::string& data = chunks[i];
+                size_t pos = 0;
+                while (pos < data.size()) {
+                    while (pos < data.size() && is_space(data[pos]))
+                        pos++;
+                    size_t start = pos;
+                    while (pos < data.size() && !is_space(data[pos]))
+                        pos++;
+                    if (start < pos)
+                        trees[i].increment(std::string(data, start, pos - start), 1);
+                }
+            }));
+        }
+        for (auto& w : workers)
+            w.join();
+    }
+
+    for (unsigned step = 1; step < threads; step *= 2) {
+        workers.clear();
+        for (unsigned i = 0; i + step < threads; i += 2 * step) {
+            workers.push_back(std::thread([&, i, step]() {
+                trees[i].merge(trees[i + step]);
+                trees[i + step].clear();
+            }));
+        }
+        for (auto& w : workers)
+            w.join();
+    }
+    return std::move(trees[0]);
+}
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+std::vector<std::pair<Key, Info>> maxinfo_selector(const avltree<Key, Info, Allocator, Stats, MaxInfo>& tree, unsigned cnt) {
+    return tree.max_info(cnt);
 }
 
 #endif //LAB3_AVLTREE__AVLTREE_H
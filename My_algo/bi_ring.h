@@ -1,10 +1,24 @@
 #ifndef STH
 #define STH
+#include <algorithm>
 #include <iostream>
+#include <queue>
+#include <thread>
 #include <vector>
+#include <utility>
+#include "container_stats.h"
 
-template <typename Key, typename Info>
-class bi_ring {
+//Stats is an instrumentation policy from container_stats.h, e.g. counting_stats
+template <typename Key, typename Info, typename Stats = no_stats>
+class bi_ring;
+
+template <typename Key, typename Info, typename Stats>
+bi_ring<Key, Info, Stats> merge(std::vector<bi_ring<Key, Info, Stats>>&& source, bool sorted = false, bool parallel = false);
+
+template <typename Key, typename Info, typename Stats>
+class bi_ring : private Stats {
+public:
+    class iterator;
 private:
     struct Node {
         Key key;
@@ -14,6 +28,24 @@ private:
     };
     Node* head;
     int size;
+
+    template <typename K, typename I>
+    Node* create(K&& k, I&& i) {
+        this->stats_allocate();
+        return new Node{ std::forward<K>(k), std::forward<I>(i), nullptr, nullptr };
+    }
+    iterator link_front(Node* n);
+    iterator link_back(Node* n);
+    iterator link_before(Node* p, Node* n);
+    template <typename Compare>
+    Node* merge_runs(Node* a, Node* b, Compare& before);
+    Node* detach();
+    void attach(Node* first, int count);
+    void merge_with(bi_ring& other);
+    void merge_heap(const std::vector<bi_ring*>& rings);
+    void link_chain(Node* p, Node* first, Node* last, int count);
+
+    friend bi_ring merge<Key, Info, Stats>(std::vector<bi_ring>&& source, bool sorted, bool parallel);
 public:
     class iterator {
     private:
@@ -100,10 +132,10 @@ public:
         bool operator!=(const const_iterator& it) const {
             return n != it.n;
         }
-        Key key() const {
+        const Key& key() const {
             return n->key;
         }
-        Info info() const {
+        const Info& info() const {
             return n->info;
         }
     };
@@ -114,10 +146,18 @@ public:
         return const_iterator(head->prev);
     }
 
+    using Stats::stats; //counters of the Stats policy, all zero with no_stats
+    using Stats::reset_stats;
+
     bi_ring() { head = nullptr; size = 0; }
     ~bi_ring() { clear(); }
     bi_ring(const bi_ring& br);
     bi_ring& operator=(const bi_ring& br);
+    bi_ring(bi_ring&& br) noexcept : head(br.head), size(br.size) {
+        br.head = nullptr;
+        br.size = 0;
+    }
+    bi_ring& operator=(bi_ring&& br) noexcept;
 
     bool empty() const;
     void print() const;
@@ -127,47 +167,205 @@ public:
     }
 
     iterator insert(iterator position, const Key& k, const Info& i); //inserts before position
+    iterator insert(iterator position, Key&& k, Info&& i);
     iterator erase(iterator position);
 
     iterator push_front(const Key& k, const Info& i);
+    iterator push_front(Key&& k, Info&& i);
     iterator pop_front();
     iterator push_back(const Key& k, const Info& i);
+    iterator push_back(Key&& k, Info&& i);
     iterator pop_back();
 
+    template <typename K, typename I>
+    iterator emplace_front(K&& k, I&& i) { this->stats_begin(STATS_INSERT); return link_front(create(std::forward<K>(k), std::forward<I>(i))); }
+    template <typename K, typename I>
+    iterator emplace_back(K&& k, I&& i) { this->stats_begin(STATS_INSERT); return link_back(create(std::forward<K>(k), std::forward<I>(i))); }
+
+    //stable merge sort by a comparator over const_iterators, before(a, b) == a goes first;
+    //only next/prev links are rewired, keys and infos never move. O(n log n), O(1) extra memory
+    template <typename Compare>
+    bool sort(Compare before);
     bool sortByInfo();
+    bool sortByKey();
+
+    //moving nodes between rings: only pointers are relinked, nothing is allocated or copied.
+    //A range [first, last) follows next from first up to last; first == last is the whole ring.
+    //Counting a partial range for the sizes is the only O(range) work.
+
+    //moves [first, last) of other before position, like insert: before begin() makes it the new front.
+    //other may be this ring if position is outside the range
+    void splice(iterator position, bi_ring& other, iterator first, iterator last);
+    void splice(iterator position, bi_ring& other); //the whole of other, O(1)
+    //moves the whole of other behind the last element, O(1)
+    void append(bi_ring& other);
+    //cuts the ring before position: this ring keeps [begin(), position), the result gets the rest
+    bi_ring split_at(iterator position);
+    //the head moves n places forward (backward for n < 0), walking at most size / 2 nodes
+    void rotate(int n);
+    void set_head(iterator position) {
+        head = position.get_node();
+    }
 
 };
 
-template<typename Key, typename Info>
-bool bi_ring<Key, Info>::empty() const {
+template<typename Key, typename Info, typename Stats>
+bool bi_ring<Key, Info, Stats>::empty() const {
     return head == nullptr && size == 0;
 }
 
-template<typename Key, typename Info>
-bool bi_ring<Key, Info>::sortByInfo() {
+//merges two null terminated, sorted chains linked by next; on ties a goes first
+template<typename Key, typename Info, typename Stats>
+template<typename Compare>
+typename bi_ring<Key, Info, Stats>::Node* bi_ring<Key, Info, Stats>::merge_runs(Node* a, Node* b, Compare& before) {
+    Node* first = nullptr;
+    Node** tail = &first;
+    while (a != nullptr && b != nullptr) {
+        this->stats_compare();
+        if (before(const_iterator(b), const_iterator(a))) {
+            *tail = b;
+            b = b->next;
+        }
+        else {
+            *tail = a;
+            a = a->next;
+        }
+        tail = &(*tail)->next;
+    }
+    *tail = a != nullptr ? a : b;
+    return first;
+}
+
+template<typename Key, typename Info, typename Stats>
+template<typename Compare>
+bool bi_ring<Key, Info, Stats>::sort(Compare before) {
     if (empty()) {
         return false;
     }
-    auto it = begin();
-    do {
-        auto it2 = it;
-        ++it2;
-        while (it2 != begin()) {
-            if (it.info() > it2.info()) {
-                std::swap(it.key(), it2.key());
-                std::swap(it.info(), it2.info());
-            }
-            ++it2;
+    this->stats_begin(STATS_OTHER);
+    //bottom-up: runs[i] is empty or a sorted chain of 2^i nodes that all came before those in runs[j < i]
+    Node* runs[64] = {};
+    int count = size;
+    Node* rest = detach();
+    while (rest != nullptr) {
+        Node* carry = rest;
+        rest = rest->next;
+        carry->next = nullptr;
+        int i = 0;
+        for (; runs[i] != nullptr; i++) {
+            carry = merge_runs(runs[i], carry, before);
+            runs[i] = nullptr;
         }
-        ++it;
-    } while (it != begin());
+        runs[i] = carry;
+    }
+    Node* sorted = nullptr;
+    for (Node* run : runs) {
+        if (run != nullptr) {
+            sorted = merge_runs(run, sorted, before);
+        }
+    }
+
+    attach(sorted, count);
     return true;
 }
 
-template<typename Key, typename Info>
-bi_ring<Key, Info>::bi_ring(const bi_ring& br) {
+//opens the ring into a null terminated chain linked by next and leaves the ring empty
+template<typename Key, typename Info, typename Stats>
+typename bi_ring<Key, Info, Stats>::Node* bi_ring<Key, Info, Stats>::detach() {
+    Node* first = head;
+    if (first != nullptr) {
+        first->prev->next = nullptr;
+    }
+    head = nullptr;
+    size = 0;
+    return first;
+}
+
+//makes a chain of count nodes the content of the empty ring: restores the prev links and closes it
+template<typename Key, typename Info, typename Stats>
+void bi_ring<Key, Info, Stats>::attach(Node* first, int count) {
+    if (first == nullptr) {
+        return;
+    }
+    head = first;
+    size = count;
+    Node* n = head;
+    while (n->next != nullptr) {
+        this->stats_visit();
+        n->next->prev = n;
+        n = n->next;
+    }
+    n->next = head;
+    head->prev = n;
+}
+
+//moves the nodes of other into this ring; both are sorted by info, ties keep this ring's nodes first
+template<typename Key, typename Info, typename Stats>
+void bi_ring<Key, Info, Stats>::merge_with(bi_ring& other) {
+    this->stats_begin(STATS_OTHER);
+    auto before = [](const_iterator a, const_iterator b) { return a.info() < b.info(); };
+    int count = size + other.size;
+    Node* a = detach();
+    attach(merge_runs(a, other.detach(), before), count);
+}
+
+//fills the empty ring with the nodes of rings sorted by info: a heap holds the front of every
+//ring and yields the smallest info, the earlier ring on ties
+template<typename Key, typename Info, typename Stats>
+void bi_ring<Key, Info, Stats>::merge_heap(const std::vector<bi_ring*>& rings) {
+    this->stats_begin(STATS_OTHER);
+    struct Front {
+        Node* n;
+        size_t ring;
+    };
+    auto after = [this](const Front& a, const Front& b) {
+        this->stats_compare();
+        if (b.n->info < a.n->info) {
+            return true;
+        }
+        return !(a.n->info < b.n->info) && a.ring > b.ring;
+    };
+    std::priority_queue<Front, std::vector<Front>, decltype(after)> fronts(after);
+    int count = 0;
+    for (size_t i = 0; i < rings.size(); i++) {
+        count += rings[i]->size;
+        Node* n = rings[i]->detach();
+        if (n != nullptr) {
+            fronts.push(Front{ n, i });
+        }
+    }
+
+    Node* first = nullptr;
+    Node** tail = &first;
+    while (!fronts.empty()) {
+        Front f = fronts.top();
+        fronts.pop();
+        *tail = f.n;
+        tail = &f.n->next;
+        if (f.n->next != nullptr) {
+            fronts.push(Front{ f.n->next, f.ring });
+        }
+    }
+    attach(first, count);
+}
+
+template<typename Key, typename Info, typename Stats>
+bool bi_ring<Key, Info, Stats>::sortByInfo() {
+    return sort([](const_iterator a, const_iterator b) { return a.info() < b.info(); });
+}
+
+template<typename Key, typename Info, typename Stats>
+bool bi_ring<Key, Info, Stats>::sortByKey() {
+    return sort([](const_iterator a, const_iterator b) { return a.key() < b.key(); });
+}
+
+template<typename Key, typename Info, typename Stats>
+bi_ring<Key, Info, Stats>::bi_ring(const bi_ring& br) {
     head = nullptr;
     size = 0;
+    if (br.empty()) {
+        return;
+    }
     auto it = br.begin();
     do {
         push_back(it.key(), it.info());
@@ -175,12 +373,15 @@ bi_ring<Key, Info>::bi_ring(const bi_ring& br) {
     } while (it != br.begin());
 }
 
-template<typename Key, typename Info>
-bi_ring<Key, Info>& bi_ring<Key, Info>::operator=(const bi_ring& br) {
+template<typename Key, typename Info, typename Stats>
+bi_ring<Key, Info, Stats>& bi_ring<Key, Info, Stats>::operator=(const bi_ring& br) {
     if (this == &br) {
         return *this;
     }
     clear();
+    if (br.empty()) {
+        return *this;
+    }
     auto it = br.begin();
     do {
         push_back(it.key(), it.info());
@@ -189,12 +390,34 @@ bi_ring<Key, Info>& bi_ring<Key, Info>::operator=(const bi_ring& br) {
     return *this;
 }
 
+template<typename Key, typename Info, typename Stats>
+bi_ring<Key, Info, Stats>& bi_ring<Key, Info, Stats>::operator=(bi_ring&& br) noexcept {
+    if (this == &br) {
+        return *this;
+    }
+    clear();
+    head = br.head;
+    size = br.size;
+    br.head = nullptr;
+    br.size = 0;
+    return *this;
+}
+
 //***********************Push and Pop***********************//
-template <typename Key, typename Info>
-typename bi_ring<Key, Info>::iterator bi_ring<Key, Info>::push_front(const Key& k, const Info& i) {
-    Node* n = new Node;
-    n->key = k;
-    n->info = i;
+template <typename Key, typename Info, typename Stats>
+typename bi_ring<Key, Info, Stats>::iterator bi_ring<Key, Info, Stats>::push_front(const Key& k, const Info& i) {
+    this->stats_begin(STATS_INSERT);
+    return link_front(create(k, i));
+}
+
+template <typename Key, typename Info, typename Stats>
+typename bi_ring<Key, Info, Stats>::iterator bi_ring<Key, Info, Stats>::push_front(Key&& k, Info&& i) {
+    this->stats_begin(STATS_INSERT);
+    return link_front(create(std::move(k), std::move(i)));
+}
+
+template <typename Key, typename Info, typename Stats>
+typename bi_ring<Key, Info, Stats>::iterator bi_ring<Key, Info, Stats>::link_front(Node* n) {
     if (empty()) {
         n->next = n;
         n->prev = n;
@@ -211,8 +434,9 @@ typename bi_ring<Key, Info>::iterator bi_ring<Key, Info>::push_front(const Key&
     return iterator(n);
 }
 
-template <typename Key, typename Info>
-typename bi_ring<Key, Info>::iterator bi_ring<Key, Info>::pop_front() {
+template <typename Key, typename Info, typename Stats>
+typename bi_ring<Key, Info, Stats>::iterator bi_ring<Key, Info, Stats>::pop_front() {
+    this->stats_begin(STATS_ERASE);
     if (empty()) {
         return iterator(nullptr);
     }
@@ -226,15 +450,25 @@ typename bi_ring<Key, Info>::iterator bi_ring<Key, Info>::pop_front() {
         n->next->prev = n->prev;
     }
     delete n;
+    this->stats_free();
     size--;
     return iterator(head);
 }
 
-template <typename Key, typename Info>
-typename bi_ring<Key, Info>::iterator bi_ring<Key, Info>::push_back(const Key& k, const Info& i) {
-    Node* n = new Node;
-    n->key = k;
-    n->info = i;
+template <typename Key, typename Info, typename Stats>
+typename bi_ring<Key, Info, Stats>::iterator bi_ring<Key, Info, Stats>::push_back(const Key& k, const Info& i) {
+    this->stats_begin(STATS_INSERT);
+    return link_back(create(k, i));
+}
+
+template <typename Key, typename Info, typename Stats>
+typename bi_ring<Key, Info, Stats>::iterator bi_ring<Key, Info, Stats>::push_back(Key&& k, Info&& i) {
+    this->stats_begin(STATS_INSERT);
+    return link_back(create(std::move(k), std::move(i)));
+}
+
+template <typename Key, typename Info, typename Stats>
+typename bi_ring<Key, Info, Stats>::iterator bi_ring<Key, Info, Stats>::link_back(Node* n) {
     if (empty()) {
         n->next = n;
         n->prev = n;
@@ -250,8 +484,9 @@ typename bi_ring<Key, Info>::iterator bi_ring<Key, Info>::push_back(const Key& k
     return iterator(n);
 }
 
-template <typename Key, typename Info>
-typename bi_ring<Key, Info>::iterator bi_ring<Key, Info>::pop_back() {
+template <typename Key, typename Info, typename Stats>
+typename bi_ring<Key, Info, Stats>::iterator bi_ring<Key, Info, Stats>::pop_back() {
+    this->stats_begin(STATS_ERASE);
     if (empty()) {
         return iterator(nullptr);
     }
@@ -264,17 +499,26 @@ typename bi_ring<Key, Info>::iterator bi_ring<Key, Info>::pop_back() {
         n->next->prev = n->prev;
     }
     delete n;
+    this->stats_free();
     size--;
     return iterator(head);
 }
 
 //***********************Insert and Erase***********************//
-template<typename Key, typename Info>
-typename bi_ring<Key, Info>::iterator bi_ring<Key, Info>::insert(iterator position, const Key& k, const Info& i) {
-    Node* n = new Node;
-    n->key = k;
-    n->info = i;
-    Node* p = position.get_node();
+template<typename Key, typename Info, typename Stats>
+typename bi_ring<Key, Info, Stats>::iterator bi_ring<Key, Info, Stats>::insert(iterator position, const Key& k, const Info& i) {
+    this->stats_begin(STATS_INSERT);
+    return link_before(position.get_node(), create(k, i));
+}
+
+template<typename Key, typename Info, typename Stats>
+typename bi_ring<Key, Info, Stats>::iterator bi_ring<Key, Info, Stats>::insert(iterator position, Key&& k, Info&& i) {
+    this->stats_begin(STATS_INSERT);
+    return link_before(position.get_node(), create(std::move(k), std::move(i)));
+}
+
+template<typename Key, typename Info, typename Stats>
+typename bi_ring<Key, Info, Stats>::iterator bi_ring<Key, Info, Stats>::link_before(Node* p, Node* n) {
     n->next = p;
     n->prev = p->prev;
     p->prev->next = n;
@@ -286,8 +530,9 @@ typename bi_ring<Key, Info>::iterator bi_ring<Key, Info>::insert(iterator positi
     return iterator(n);
 }
 
-template<typename Key, typename Info>
-typename bi_ring<Key, Info>::iterator bi_ring<Key, Info>::erase(iterator position) {
+template<typename Key, typename Info, typename Stats>
+typename bi_ring<Key, Info, Stats>::iterator bi_ring<Key, Info, Stats>::erase(iterator position) {
+    this->stats_begin(STATS_ERASE);
     if (empty()) {
         return iterator(nullptr);
     }
@@ -303,14 +548,130 @@ typename bi_ring<Key, Info>::iterator bi_ring<Key, Info>::erase(iterator positio
         }
     }
     delete n;
+    this->stats_free();
     size--;
     return iterator(head);
 }
 
 
+//***********************Splicing***********************//
+//links the chain first .. last (last included) of count nodes before p, or makes it the ring when empty
+template<typename Key, typename Info, typename Stats>
+void bi_ring<Key, Info, Stats>::link_chain(Node* p, Node* first, Node* last, int count) {
+    if (empty()) {
+        first->prev = last;
+        last->next = first;
+        head = first;
+    }
+    else {
+        first->prev = p->prev;
+        last->next = p;
+        p->prev->next = first;
+        p->prev = last;
+    }
+    size += count;
+}
+
+template<typename Key, typename Info, typename Stats>
+void bi_ring<Key, Info, Stats>::splice(iterator position, bi_ring& other, iterator first, iterator last) {
+    this->stats_begin(STATS_OTHER);
+    if (other.empty()) {
+        return;
+    }
+    Node* a = first.get_node();
+    Node* stop = last.get_node();
+    Node* b = stop->prev;
+    int count = 0;
+    bool moves_head = false;
+    if (a == stop) {
+        count = other.size;
+        moves_head = true;
+    }
+    else {
+        for (Node* n = a; n != stop; n = n->next) {
+            this->stats_visit();
+            moves_head = moves_head || n == other.head;
+            count++;
+        }
+    }
+    if (&other == this && count == size) { //the whole ring onto itself
+        return;
+    }
+
+    if (count == other.size) {
+        other.head = nullptr;
+    }
+    else {
+        a->prev->next = stop;
+        stop->prev = a->prev;
+        if (moves_head) {
+            other.head = stop;
+        }
+    }
+    other.size -= count;
+
+    Node* p = position.get_node();
+    link_chain(p, a, b, count);
+    if (p == head) {
+        head = a;
+    }
+}
+
+template<typename Key, typename Info, typename Stats>
+void bi_ring<Key, Info, Stats>::splice(iterator position, bi_ring& other) {
+    if (other.empty() || &other == this) {
+        return;
+    }
+    splice(position, other, other.begin(), other.begin());
+}
+
+template<typename Key, typename Info, typename Stats>
+void bi_ring<Key, Info, Stats>::append(bi_ring& other) {
+    this->stats_begin(STATS_OTHER);
+    if (other.empty() || &other == this) {
+        return;
+    }
+    int count = other.size;
+    Node* first = other.detach();
+    link_chain(head, first, first->prev, count);
+}
+
+template<typename Key, typename Info, typename Stats>
+bi_ring<Key, Info, Stats> bi_ring<Key, Info, Stats>::split_at(iterator position) {
+    bi_ring result;
+    if (!empty()) {
+        result.splice(result.begin(), *this, position, begin());
+    }
+    return result;
+}
+
+template<typename Key, typename Info, typename Stats>
+void bi_ring<Key, Info, Stats>::rotate(int n) {
+    this->stats_begin(STATS_OTHER);
+    if (size < 2) {
+        return;
+    }
+    n %= size;
+    if (n < 0) {
+        n += size;
+    }
+    if (n <= size / 2) {
+        for (; n > 0; n--) {
+            this->stats_visit();
+            head = head->next;
+        }
+    }
+    else {
+        for (n = size - n; n > 0; n--) {
+            this->stats_visit();
+            head = head->prev;
+        }
+    }
+}
+
 //***********************Deleting***********************//
-template<typename Key, typename Info>
-void bi_ring<Key, Info>::clear() {
+template<typename Key, typename Info, typename Stats>
+void bi_ring<Key, Info, Stats>::clear() {
     if (empty()) {
         return;
     }
@@ -319,6 +680,7 @@ void bi_ring<Key, Info>::clear() {
         Node* tmp = n;
         n = n->next;
         delete tmp;
+        this->stats_free();
     } while (n != head);
     head = nullptr;
     size = 0;
@@ -326,8 +688,8 @@ void bi_ring<Key, Info>::clear() {
 }
 
 //***********************Printing***********************//
-template<typename Key, typename Info>
-void bi_ring<Key, Info>::print() const {
+template<typename Key, typename Info, typename Stats>
+void bi_ring<Key, Info, Stats>::print() const {
     if (empty()) {
         std::cout << "Empty list\n" << std::endl;
         return;
@@ -342,20 +704,70 @@ void bi_ring<Key, Info>::print() const {
 }
 
 
-template<typename Key, typename Info>
-bi_ring<Key, Info> merge(const std::vector<bi_ring<Key, Info>>& source) {
-    bi_ring<Key, Info> result;
-    for (auto br : source) {
-        auto it = br.begin();
-        do {
-            result.push_back(it.key(), it.info());
-            it++;
-        } while (it != br.begin());
+//merges rings sorted by info into one ring sorted by info; the nodes of source are moved, never
+//copied, and source is left with empty rings. Ties keep the order of source. With sorted == false
+//every ring is sorted first. Serially a heap picks the next node from the k ring fronts, O(N log k);
+//parallel merges pairs of rings on all cores instead, log k rounds of O(N) work
+template<typename Key, typename Info, typename Stats>
+bi_ring<Key, Info, Stats> merge(std::vector<bi_ring<Key, Info, Stats>>&& source, bool sorted, bool parallel) {
+    std::vector<bi_ring<Key, Info, Stats>*> rings;
+    for (auto& br : source) {
+        if (!br.empty()) {
+            rings.push_back(&br);
+        }
+    }
+    unsigned threads = parallel && !Stats::enabled ? std::thread::hardware_concurrency() : 1; //the counters are not thread safe
+    if (threads == 0) {
+        threads = 1;
+    }
+    //runs task(0) .. task(count - 1) spread over up to threads workers
+    auto run = [threads](size_t count, auto task) {
+        size_t workers = std::min<size_t>(threads, count);
+        if (workers <= 1) {
+            for (size_t i = 0; i < count; i++) {
+                task(i);
+            }
+            return;
+        }
+        std::vector<std::thread> pool;
+        for (size_t w = 0; w < workers; w++) {
+            pool.push_back(std::thread([&, w]() {
+                for (size_t i = w; i < count; i += workers) {
+                    task(i);
+                }
+            }));
+        }
+        for (auto& t : pool) {
+            t.join();
+        }
+    };
+
+    if (!sorted) {
+        run(rings.size(), [&](size_t i) { rings[i]->sortByInfo(); });
+    }
+    bi_ring<Key, Info, Stats> result;
+    if (threads > 1 && rings.size() > 2) {
+        for (size_t step = 1; step < rings.size(); step *= 2) {
+            run((rings.size() + step - 1) / (2 * step), [&, step](size_t pair) {
+                size_t i = 2 * step * pair;
+                rings[i]->merge_with(*rings[i + step]);
+            });
+        }
+        result = std::move(*rings[0]);
+    }
+    else {
+        result.merge_heap(rings);
     }
-    result.sortByInfo();
     return result;
 }
 
+//copying version: merges copies of the rings, source stays as it is
+template<typename Key, typename Info, typename Stats>
+bi_ring<Key, Info, Stats> merge(const std::vector<bi_ring<Key, Info, Stats>>& source) {
+    std::vector<bi_ring<Key, Info, Stats>> copies(source);
+    return merge(std::move(copies));
+}
+
 // template<typename Key, typename Info>
 // bi_ring<Key, Info> filter(const bi_ring<Key, Info>& source, bool (pred)(const Key&) ){
 
@@ -0,0 +1,78 @@
+#ifndef CONTAINER_STATS_H
+#define CONTAINER_STATS_H
+#include <cstdint>
+
+//Instrumentation policies for the containers.
+//A container derives from its policy and reports the work of every operation through
+//the protected hooks; no_stats turns them all into empty inline calls, counting_stats
+//adds them up. Hooks are const so lookups can count as well. Counts go to the operation
+//type given by the last stats_begin(), so an operation built from others (e.g.
+//Dictionary::insert = find + insert) shows up under each of them.
+//counting_stats is not thread safe; parallel set operations run serially while it is used.
+
+enum stats_op { STATS_INSERT, STATS_FIND, STATS_ERASE, STATS_OTHER, STATS_OPS };
+
+struct op_stats {
+    uint64_t calls;
+    uint64_t comparisons;   //key comparisons (info comparisons when sorting by info)
+    uint64_t nodes_visited;
+    uint64_t probes;        //control groups or slots inspected by hash tables
+};
+
+struct container_stats {
+    op_stats ops[STATS_OPS];
+    uint64_t allocations;
+    uint64_t frees;
+    uint64_t rotations;
+
+    const op_stats& operator[](stats_op op) const { return ops[op]; }
+};
+
+//default: nothing is counted and stats() is always zero
+class no_stats {
+public:
+    static constexpr bool enabled = false;
+
+    container_stats stats() const { return container_stats(); }
+    void reset_stats() {}
+
+protected:
+    void stats_begin(stats_op) const {}
+    void stats_compare(uint64_t = 1) const {}
+    void stats_visit(uint64_t = 1) const {}
+    void stats_probe(uint64_t = 1) const {}
+    void stats_allocate() const {}
+    void stats_free() const {}
+    void stats_rotate() const {}
+};
+
+class counting_stats {
+private:
+    mutable container_stats counters;
+    mutable stats_op current;
+
+public:
+    static constexpr bool enabled = true;
+
+    counting_stats() : counters(), current(STATS_OTHER) {}
+
+    container_stats stats() const { return counters; }
+    void reset_stats() {
+        counters = container_stats();
+        current = STATS_OTHER;
+    }
+
+protected:
+    void stats_begin(stats_op op) const {
+        current = op;
+        counters.ops[op].calls++;
+    }
+    void stats_compare(uint64_t n = 1) const { counters.ops[current].comparisons += n; }
+    void stats_visit(uint64_t n = 1) const { counters.ops[current].nodes_visited += n; }
+    void stats_probe(uint64_t n = 1) const { counters.ops[current].probes += n; }
+    void stats_allocate() const { counters.allocations++; }
+    void stats_free() const { counters.frees++; }
+    void stats_rotate() const { counters.rotations++; }
+};
+
+#endif
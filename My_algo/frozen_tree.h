@@ -0,0 +1,129 @@
+#ifndef FROZEN_TREE_H
+#define FROZEN_TREE_H
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <xmmintrin.h>
+#define FROZEN_PREFETCH(p) _mm_prefetch(reinterpret_cast<const char*>(p), _MM_HINT_T0)
+#else
+#define FROZEN_PREFETCH(p) __builtin_prefetch(p)
+#endif
+
+//Immutable, read-only copy of an avltree (see avltree::freeze()).
+//Keys are stored in Eytzinger (BFS) order in one array and infos in a parallel one,
+//so a lookup walks a single contiguous array, the descent has no data-dependent
+//branches and the next levels can be prefetched ahead of the comparisons.
+template <typename Key, typename Info>
+class frozen_avltree {
+private:
+    //1-based: node k has children 2k and 2k + 1, slot 0 is unused
+    std::vector<Key> keys;
+    std::vector<Info> infos;
+    size_t n;
+
+    //how many children indices fit in one cache line, i.e. how far ahead to prefetch
+    static constexpr size_t PER_LINE = sizeof(Key) >= 64 ? 1 : 64 / sizeof(Key);
+
+    static unsigned trailing_zeros(uint64_t x) {
+#if defined(_MSC_VER)
+        unsigned long i;
+        _BitScanForward64(&i, x);
+        return i;
+#else
+        return __builtin_ctzll(x);
+#endif
+    }
+
+    //lays out sorted[i..] in in-order over the implicit tree rooted at k
+    template <typename K, typename I>
+    size_t fill(std::vector<std::pair<K, I>>& sorted, size_t i, size_t k) {
+        if (k <= n) {
+            i = fill(sorted, i, 2 * k);
+            keys[k] = std::move(sorted[i].first);
+            infos[k] = std::move(sorted[i].second);
+            i++;
+            i = fill(sorted, i, 2 * k + 1);
+        }
+        return i;
+    }
+
+    void prefetch(size_t k) const {
+        size_t ahead = k * PER_LINE;
+        if (ahead < keys.size())
+            FROZEN_PREFETCH(&keys[ahead]);
+    }
+
+    //one step of the descent; key < keys[k] goes left, anything else right
+    size_t step(size_t k, const Key& key) const {
+        return 2 * k + (keys[k] < key ? 1 : 0);
+    }
+
+    //the descent ran past the leaves; undo the right turns taken after the last
+    //left one, which is where the lower bound was passed
+    const Info* finish(size_t k, const Key& key) const {
+        k >>= trailing_zeros(~static_cast<uint64_t>(k)) + 1;
+        if (k == 0 || key < keys[k])
+            return nullptr;
+        return &infos[k];
+    }
+
+public:
+    frozen_avltree() : keys(1), infos(1), n(0) {}
+
+    //entries must be sorted by key without duplicates
+    template <typename K, typename I>
+    explicit frozen_avltree(std::vector<std::pair<K, I>> sorted)
+        : keys(sorted.size() + 1), infos(sorted.size() + 1), n(sorted.size()) {
+        fill(sorted, 0, 1);
+    }
+
+    size_t size() const { return n; }
+    bool isEmpty() const { return n == 0; }
+
+    bool search(const Key& key) const {
+        return find(key) != nullptr;
+    }
+
+    //returns nullptr when key is missing
+    const Info* find(const Key& key) const {
+        size_t k = 1;
+        while (k <= n) {
+            prefetch(k);
+            k = step(k, key);
+        }
+        return finish(k, key);
+    }
+
+    //answers many lookups at once; GROUP descents advance in lockstep so their
+    //cache misses overlap instead of being paid one after another
+    std::vector<const Info*> find_many(const std::vector<Key>& queries) const {
+        static const size_t GROUP = 8;
+        std::vector<const Info*> results(queries.size());
+        for (size_t base = 0; base < queries.size(); base += GROUP) {
+            size_t cnt = queries.size() - base < GROUP ? queries.size() - base : GROUP;
+            size_t k[GROUP];
+            for (size_t j = 0; j < cnt; j++)
+                k[j] = 1;
+            //all descents have the same length, except that the last level may be partial
+            bool running = n > 0;
+            while (running) {
+                running = false;
+                for (size_t j = 0; j < cnt; j++) {
+                    if (k[j] <= n) {
+                        prefetch(k[j]);
+                        k[j] = step(k[j], queries[base + j]);
+                        running = true;
+                    }
+                }
+            }
+            for (size_t j = 0; j < cnt; j++)
+                results[base + j] = finish(k[j], queries[base + j]);
+        }
+        return results;
+    }
+};
+
+#endif
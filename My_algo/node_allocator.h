@@ -0,0 +1,110 @@
+#ifndef NODE_ALLOCATOR_H
+#define NODE_ALLOCATOR_H
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+//Allocator policies for container nodes.
+//A policy hands out raw, uninitialized storage for one T at a time; the container
+//constructs and destroys the object itself. reset() returns every slot at once,
+//and can_reset tells the container whether that is cheaper than freeing node by node.
+//stateless policies let nodes move between containers and be freed from any thread.
+
+//every node goes straight to the global heap
+template <typename T>
+class heap_allocator {
+public:
+    static constexpr bool can_reset = false;
+    static constexpr bool stateless = true;
+
+    T* allocate() {
+        return static_cast<T*>(::operator new(sizeof(T)));
+    }
+    void deallocate(T* p) {
+        ::operator delete(p);
+    }
+    void reset() {}
+};
+
+//nodes are carved out of slabs; freed nodes go to a free list and are reused,
+//reset() makes all slabs available again without giving the memory back
+template <typename T>
+class pool_allocator {
+private:
+    static constexpr std::size_t SlabSize = 256;
+
+    union Slot {
+        Slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    std::vector<Slot*> slabs;
+    Slot* free_list;
+    std::size_t current;    //index of the slab we are bumping through
+    std::size_t used;       //slots handed out from slabs[current]
+
+    void release() {
+        for (Slot* slab : slabs)
+            delete[] slab;
+        slabs.clear();
+    }
+
+public:
+    static constexpr bool can_reset = true;
+    static constexpr bool stateless = false;
+
+    pool_allocator() : free_list(nullptr), current(0), used(SlabSize) {}
+    ~pool_allocator() { release(); }
+
+    //a pool owns its memory, copies start empty
+    pool_allocator(const pool_allocator&) : pool_allocator() {}
+    pool_allocator& operator=(const pool_allocator&) { return *this; }
+    //moving hands the slabs, and with them every live node, to the new owner
+    pool_allocator(pool_allocator&& rhs) noexcept : pool_allocator() { swap(rhs); }
+    pool_allocator& operator=(pool_allocator&& rhs) noexcept {
+        swap(rhs);
+        return *this;
+    }
+
+    void swap(pool_allocator& rhs) noexcept {
+        slabs.swap(rhs.slabs);
+        std::swap(free_list, rhs.free_list);
+        std::swap(current, rhs.current);
+        std::swap(used, rhs.used);
+    }
+
+    T* allocate() {
+        if (free_list != nullptr) {
+            Slot* s = free_list;
+            free_list = s->next;
+            return reinterpret_cast<T*>(s->storage);
+        }
+        if (used == SlabSize) {
+            if (slabs.empty() || current + 1 == slabs.size()) {
+                slabs.push_back(new Slot[SlabSize]);
+                current = slabs.size() - 1;
+            }
+            else
+                current++;
+            used = 0;
+        }
+        return reinterpret_cast<T*>(slabs[current][used++].storage);
+    }
+
+    void deallocate(T* p) {
+        Slot* s = reinterpret_cast<Slot*>(p);
+        s->next = free_list;
+        free_list = s;
+    }
+
+    void reset() {
+        free_list = nullptr;
+        current = 0;
+        used = slabs.empty() ? SlabSize : 0;
+    }
+
+    std::size_t capacity() const { return slabs.size() * SlabSize; }
+};
+
+#endif
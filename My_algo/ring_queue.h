@@ -0,0 +1,283 @@
+#ifndef RING_QUEUE_H
+#define RING_QUEUE_H
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+//Bounded FIFO queues of key/info pairs for handing work between threads without a mutex.
+//Both keep the elements in one array whose capacity is the requested one rounded up to a power
+//of two, and count positions with ever growing indices that are masked into the array.
+//The producer and consumer indices sit on cache lines of their own so the two sides do not
+//invalidate each other's line on every operation. Batch push/pop move as many pairs as fit
+//with one index update. try_* return false (batches: a smaller count) instead of waiting.
+//No Stats policy: the counters of container_stats.h are not thread safe.
+
+namespace ring_queue_detail {
+    static const size_t CACHE_LINE = 64;
+
+    inline size_t round_capacity(size_t n) {
+        size_t cap = 2;
+        while (cap < n) {
+            cap *= 2;
+        }
+        return cap;
+    }
+
+    template <typename Key, typename Info>
+    struct entry {
+        Key key;
+        Info info;
+    };
+}
+
+//single producer, single consumer: each side owns one index and caches the other side's,
+//so most operations touch no shared line at all
+template <typename Key, typename Info>
+class spsc_ring {
+private:
+    typedef ring_queue_detail::entry<Key, Info> Entry;
+    typedef typename std::aligned_storage<sizeof(Entry), alignof(Entry)>::type Slot;
+
+    Slot* slots;
+    size_t mask;
+
+    alignas(ring_queue_detail::CACHE_LINE) std::atomic<size_t> tail; //written by the producer
+    size_t head_cache; //producer's last view of head
+    alignas(ring_queue_detail::CACHE_LINE) std::atomic<size_t> head; //written by the consumer
+    size_t tail_cache; //consumer's last view of tail
+    char pad[ring_queue_detail::CACHE_LINE - sizeof(size_t)];
+
+    Entry* at(size_t pos) {
+        return reinterpret_cast<Entry*>(&slots[pos & mask]);
+    }
+    //free slots for the producer, rereading head only when the cached view is not enough
+    size_t room(size_t t, size_t wanted) {
+        size_t free = mask + 1 - (t - head_cache);
+        if (free < wanted) {
+            head_cache = head.load(std::memory_order_acquire);
+            free = mask + 1 - (t - head_cache);
+        }
+        return free;
+    }
+    //filled slots for the consumer, likewise
+    size_t filled(size_t h, size_t wanted) {
+        size_t used = tail_cache - h;
+        if (used < wanted) {
+            tail_cache = tail.load(std::memory_order_acquire);
+            used = tail_cache - h;
+        }
+        return used;
+    }
+public:
+    explicit spsc_ring(size_t capacity) : slots(new Slot[ring_queue_detail::round_capacity(capacity)]),
+        mask(ring_queue_detail::round_capacity(capacity) - 1), tail(0), head_cache(0), head(0), tail_cache(0) {}
+    ~spsc_ring() {
+        for (size_t pos = head.load(); pos != tail.load(); pos++) {
+            at(pos)->~Entry();
+        }
+        delete[] slots;
+    }
+    spsc_ring(const spsc_ring&) = delete;
+    spsc_ring& operator=(const spsc_ring&) = delete;
+
+    size_t capacity() const {
+        return mask + 1;
+    }
+    //a snapshot, exact only while neither side is working
+    size_t get_size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+    bool empty() const {
+        return get_size() == 0;
+    }
+
+    //producer side
+    template <typename K, typename I>
+    bool try_push(K&& k, I&& i) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (room(t, 1) == 0) {
+            return false;
+        }
+        new (at(t)) Entry{ std::forward<K>(k), std::forward<I>(i) };
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+    //pushes the leading (key, info) pairs of [first, last) that fit, returns how many
+    template <typename It>
+    size_t try_push_batch(It first, It last) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t wanted = static_cast<size_t>(std::distance(first, last));
+        size_t n = std::min(wanted, room(t, wanted));
+        for (size_t j = 0; j < n; j++, ++first) {
+            new (at(t + j)) Entry{ first->first, first->second };
+        }
+        tail.store(t + n, std::memory_order_release);
+        return n;
+    }
+
+    //consumer side
+    bool try_pop(Key& k, Info& i) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (filled(h, 1) == 0) {
+            return false;
+        }
+        Entry* e = at(h);
+        k = std::move(e->key);
+        i = std::move(e->info);
+        e->~Entry();
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+    //writes up to max pairs to out as std::pair<Key, Info>, returns how many
+    template <typename Out>
+    size_t try_pop_batch(Out out, size_t max) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t n = std::min(max, filled(h, max));
+        for (size_t j = 0; j < n; j++) {
+            Entry* e = at(h + j);
+            *out++ = std::pair<Key, Info>(std::move(e->key), std::move(e->info));
+            e->~Entry();
+        }
+        head.store(h + n, std::memory_order_release);
+        return n;
+    }
+};
+
+//multiple producers and consumers, after Vyukov's bounded queue. Every slot carries a sequence
+//number that hands it over: pos while it waits for the producer of pos, pos + 1 once it holds that
+//element and pos + capacity after its consumer is done. A thread reads the sequence of the slot at
+//tail (head) before it claims anything and moves the index forward with one compare-exchange only
+//over slots that are already handed to its side, so once a run is claimed it is filled (emptied)
+//without waiting. A slot still owned by a preempted thread of the other side makes try_* return
+//false (batches: stop short) rather than stall behind it
+template <typename Key, typename Info>
+class mpmc_ring {
+private:
+    typedef ring_queue_detail::entry<Key, Info> Entry;
+    struct Slot {
+        std::atomic<size_t> sequence;
+        typename std::aligned_storage<sizeof(Entry), alignof(Entry)>::type storage;
+    };
+
+    Slot* slots;
+    size_t mask;
+
+    alignas(ring_queue_detail::CACHE_LINE) std::atomic<size_t> tail; //next position to produce
+    alignas(ring_queue_detail::CACHE_LINE) std::atomic<size_t> head; //next position to consume
+    char pad[ring_queue_detail::CACHE_LINE - sizeof(size_t)];
+
+    Entry* at(size_t pos) {
+        return reinterpret_cast<Entry*>(&slots[pos & mask].storage);
+    }
+    //claims up to wanted positions from index, whose slots are ready once their sequence is pos + ready
+    //(0 for producers, 1 for consumers); returns the first one and sets n, 0 when the first slot is not ready
+    size_t claim(std::atomic<size_t>& index, size_t ready, size_t wanted, size_t& n) {
+        size_t pos = index.load(std::memory_order_relaxed);
+        for (;;) {
+            n = 0;
+            size_t seq = pos + ready;
+            while (n < wanted && n <= mask) {
+                seq = slots[(pos + n) & mask].sequence.load(std::memory_order_acquire);
+                if (seq != pos + n + ready) {
+                    break;
+                }
+                n++;
+            }
+            if (n == 0) {
+                //behind pos: the slot still belongs to the other side (full or empty queue, or a preempted thread)
+                if (wanted == 0 || static_cast<std::ptrdiff_t>(seq - (pos + ready)) < 0) {
+                    return pos;
+                }
+                pos = index.load(std::memory_order_relaxed); //ahead: pos was taken meanwhile
+                continue;
+            }
+            if (index.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) {
+                return pos;
+            }
+        }
+    }
+public:
+    explicit mpmc_ring(size_t capacity) : slots(new Slot[ring_queue_detail::round_capacity(capacity)]),
+        mask(ring_queue_detail::round_capacity(capacity) - 1), tail(0), head(0) {
+        for (size_t pos = 0; pos <= mask; pos++) {
+            slots[pos].sequence.store(pos, std::memory_order_relaxed);
+        }
+    }
+    ~mpmc_ring() {
+        for (size_t pos = head.load(); pos != tail.load(); pos++) {
+            at(pos)->~Entry();
+        }
+        delete[] slots;
+    }
+    mpmc_ring(const mpmc_ring&) = delete;
+    mpmc_ring& operator=(const mpmc_ring&) = delete;
+
+    size_t capacity() const {
+        return mask + 1;
+    }
+    //a snapshot, counts claimed positions
+    size_t get_size() const {
+        size_t h = head.load(std::memory_order_acquire);
+        size_t t = tail.load(std::memory_order_acquire);
+        return t > h ? t - h : 0;
+    }
+    bool empty() const {
+        return get_size() == 0;
+    }
+
+    template <typename K, typename I>
+    bool try_push(K&& k, I&& i) {
+        size_t n;
+        size_t pos = claim(tail, 0, 1, n);
+        if (n == 0) {
+            return false;
+        }
+        new (at(pos)) Entry{ std::forward<K>(k), std::forward<I>(i) };
+        slots[pos & mask].sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+    //pushes the leading (key, info) pairs of [first, last) that fit, returns how many
+    template <typename It>
+    size_t try_push_batch(It first, It last) {
+        size_t n;
+        size_t pos = claim(tail, 0, static_cast<size_t>(std::distance(first, last)), n);
+        for (size_t j = 0; j < n; j++, ++first) {
+            new (at(pos + j)) Entry{ first->first, first->second };
+            slots[(pos + j) & mask].sequence.store(pos + j + 1, std::memory_order_release);
+        }
+        return n;
+    }
+
+    bool try_pop(Key& k, Info& i) {
+        size_t n;
+        size_t pos = claim(head, 1, 1, n);
+        if (n == 0) {
+            return false;
+        }
+        Entry* e = at(pos);
+        k = std::move(e->key);
+        i = std::move(e->info);
+        e->~Entry();
+        slots[pos & mask].sequence.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+    //writes up to max pairs to out as std::pair<Key, Info>, returns how many
+    template <typename Out>
+    size_t try_pop_batch(Out out, size_t max) {
+        size_t n;
+        size_t pos = claim(head, 1, max, n);
+        for (size_t j = 0; j < n; j++) {
+            Entry* e = at(pos + j);
+            *out++ = std::pair<Key, Info>(std::move(e->key), std::move(e->info));
+            e->~Entry();
+            slots[(pos + j) & mask].sequence.store(pos + j + mask + 1, std::memory_order_release);
+        }
+        return n;
+    }
+};
+
+#endif
@@ -0,0 +1,389 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//Binary snapshot of a sorted key -> info map, written by save(tree, path) or save(dictionary, path)
+//at the end of this file and opened read-only through mmap so queries can start without rebuilding
+//any nodes. Only this header pulls in the platform mapping API; the containers do not include it.
+//
+//File layout, native byte order, every section starts at a multiple of 8 bytes:
+//  header       magic, version, column types, entry count and section offsets
+//  key column   count fixed-width keys, or count + 1 uint64 offsets into the key blob
+//  info column  the same for the infos
+//  key blob     bytes of all string keys
+//  info blob    bytes of all string infos
+//A reader refuses files with another magic, version or column types.
+
+static const char SNAPSHOT_MAGIC[8] = { 'A', 'V', 'L', 'S', 'N', 'A', 'P', '\0' };
+static const uint32_t SNAPSHOT_VERSION = 1;
+
+struct snapshot_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t key_type;
+    uint32_t info_type;
+    uint32_t reserved;
+    uint64_t count;
+    uint64_t key_column;
+    uint64_t info_column;
+    uint64_t key_blob;
+    uint64_t info_blob;
+    uint64_t file_size;
+};
+
+//how one key or info type is laid out in a column; arithmetic types and std::string are supported
+template <typename T, typename Enable = void>
+struct snapshot_column;
+
+template <typename T>
+struct snapshot_column<T, typename std::enable_if<std::is_arithmetic<T>::value>::type> {
+    static_assert(alignof(T) <= 8, "columns are only aligned to 8 bytes");
+
+    //kind in the high bits (1 signed, 2 unsigned, 3 floating), width in the low byte
+    static const uint32_t type = (std::is_floating_point<T>::value ? 3u : std::is_signed<T>::value ? 1u : 2u) << 8 | sizeof(T);
+
+    static void add(std::string& column, std::string&, const T& value) {
+        column.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    static void finish(std::string&, const std::string&) {}
+    //whether count values fit in bytes; never overflows, count comes from the file
+    static bool fits(uint64_t count, uint64_t bytes) { return count <= bytes / sizeof(T); }
+
+    static T get(const char* column, const char*, size_t i) {
+        return reinterpret_cast<const T*>(column)[i];
+    }
+    static bool less(const char* column, const char*, size_t i, const T& value) {
+        return reinterpret_cast<const T*>(column)[i] < value;
+    }
+    static bool equal(const char* column, const char*, size_t i, const T& value) {
+        return reinterpret_cast<const T*>(column)[i] == value;
+    }
+    //the offsets of a fixed column need no checking
+    static bool valid(const char*, uint64_t, uint64_t) { return true; }
+};
+
+template <>
+struct snapshot_column<std::string> {
+    static const uint32_t type = 4u << 8;
+
+    static void add(std::string& column, std::string& blob, const std::string& value) {
+        uint64_t offset = blob.size();
+        column.append(reinterpret_cast<const char*>(&offset), sizeof(offset));
+        blob += value;
+    }
+    static void finish(std::string& column, const std::string& blob) {
+        uint64_t end = blob.size();
+        column.append(reinterpret_cast<const char*>(&end), sizeof(end));
+    }
+    static bool fits(uint64_t count, uint64_t bytes) {
+        return bytes >= sizeof(uint64_t) && count <= bytes / sizeof(uint64_t) - 1;
+    }
+
+    static std::string get(const char* column, const char* blob, size_t i) {
+        const uint64_t* offsets = reinterpret_cast<const uint64_t*>(column);
+        return std::string(blob + offsets[i], blob + offsets[i + 1]);
+    }
+    //same order as std::string::compare, without building a string
+    static int compare(const char* column, const char* blob, size_t i, const std::string& value) {
+        const uint64_t* offsets = reinterpret_cast<const uint64_t*>(column);
+        size_t len = static_cast<size_t>(offsets[i + 1] - offsets[i]);
+        size_t common = len < value.size() ? len : value.size();
+        int c = common ? std::memcmp(blob + offsets[i], value.data(), common) : 0;
+        if (c != 0)
+            return c;
+        return len < value.size() ? -1 : len > value.size() ? 1 : 0;
+    }
+    static bool less(const char* column, const char* blob, size_t i, const std::string& value) {
+        return compare(column, blob, i, value) < 0;
+    }
+    static bool equal(const char* column, const char* blob, size_t i, const std::string& value) {
+        return compare(column, blob, i, value) == 0;
+    }
+    //offsets must be ascending and stay inside the blob
+    static bool valid(const char* column, uint64_t count, uint64_t blob_size) {
+        const uint64_t* offsets = reinterpret_cast<const uint64_t*>(column);
+        if (offsets[0] != 0 || offsets[count] > blob_size)
+            return false;
+        for (uint64_t i = 0; i < count; i++)
+            if (offsets[i] > offsets[i + 1])
+                return false;
+        return true;
+    }
+};
+
+//collects entries in ascending key order and writes them as one snapshot file
+template <typename Key, typename Info>
+class snapshot_writer {
+private:
+    typedef snapshot_column<Key> key_column;
+    typedef snapshot_column<Info> info_column;
+
+    std::string keys, infos, key_blob, info_blob;
+    uint64_t count;
+
+    static uint64_t aligned(uint64_t offset) {
+        return (offset + 7) & ~static_cast<uint64_t>(7);
+    }
+
+    static void write_section(std::ofstream& out, const std::string& bytes, uint64_t& pos, uint64_t start) {
+        static const char zeros[8] = {};
+        out.write(zeros, static_cast<std::streamsize>(start - pos));
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        pos = start + bytes.size();
+    }
+
+public:
+    snapshot_writer() : count(0) {}
+
+    //keys must come in ascending order without duplicates
+    void add(const Key& key, const Info& info) {
+        key_column::add(keys, key_blob, key);
+        info_column::add(infos, info_blob, info);
+        count++;
+    }
+
+    //call once, after the last add
+    void write(const std::string& path) {
+        key_column::finish(keys, key_blob);
+        info_column::finish(infos, info_blob);
+
+        snapshot_header header = {};
+        std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version = SNAPSHOT_VERSION;
+        header.key_type = key_column::type;
+        header.info_type = info_column::type;
+        header.count = count;
+        header.key_column = aligned(sizeof(header));
+        header.info_column = aligned(header.key_column + keys.size());
+        header.key_blob = aligned(header.info_column + infos.size());
+        header.info_blob = aligned(header.key_blob + key_blob.size());
+        header.file_size = header.info_blob + info_blob.size();
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out)
+            throw std::runtime_error("cannot create snapshot " + path);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        uint64_t pos = sizeof(header);
+        write_section(out, keys, pos, header.key_column);
+        write_section(out, infos, pos, header.info_column);
+        write_section(out, key_blob, pos, header.key_blob);
+        write_section(out, info_blob, pos, header.info_blob);
+        if (!out.flush())
+            throw std::runtime_error("cannot write snapshot " + path);
+    }
+};
+
+//read-only view of a snapshot file; lookups binary search the mapped key column
+template <typename Key, typename Info>
+class mapped_snapshot {
+private:
+    typedef snapshot_column<Key> key_column;
+    typedef snapshot_column<Info> info_column;
+
+    const char* base;
+    size_t length;
+#if defined(_WIN32)
+    HANDLE file;
+    HANDLE mapping;
+#endif
+    uint64_t n;
+    const char* keys;
+    const char* infos;
+    const char* key_blob;
+    const char* info_blob;
+
+    void map(const std::string& path) {
+#if defined(_WIN32)
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("cannot open snapshot " + path);
+        LARGE_INTEGER size;
+        GetFileSizeEx(file, &size);
+        length = static_cast<size_t>(size.QuadPart);
+        mapping = length ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+        base = mapping ? static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("cannot open snapshot " + path);
+        struct stat st;
+        length = fstat(fd, &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+        void* p = length ? mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+        ::close(fd);
+        base = p == MAP_FAILED ? nullptr : static_cast<const char*>(p);
+#endif
+        if (!base) {
+            unmap();
+            throw std::runtime_error("cannot map snapshot " + path);
+        }
+    }
+
+    void unmap() {
+#if defined(_WIN32)
+        if (base)
+            UnmapViewOfFile(base);
+        if (mapping)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+        mapping = nullptr;
+#else
+        if (base)
+            munmap(const_cast<char*>(base), length);
+#endif
+        base = nullptr;
+        length = 0;
+    }
+
+    void check(const std::string& path) {
+        snapshot_header header;
+        if (length < sizeof(header))
+            throw std::runtime_error("truncated snapshot " + path);
+        std::memcpy(&header, base, sizeof(header));
+        if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0)
+            throw std::runtime_error("not a snapshot: " + path);
+        if (header.version != SNAPSHOT_VERSION)
+            throw std::runtime_error("unsupported snapshot version in " + path);
+        if (header.key_type != key_column::type || header.info_type != info_column::type)
+            throw std::runtime_error("snapshot " + path + " holds other key or info types");
+        //sections must be ordered inside the file before any size is derived from them, and the
+        //columns are checked by dividing their room, so no sum of file values can wrap around
+        if (header.file_size != length || header.key_column < sizeof(header)
+            || header.key_column > header.info_column || header.info_column > header.key_blob
+            || header.key_blob > header.info_blob || header.info_blob > length
+            || (header.key_column | header.info_column | header.key_blob | header.info_blob) % 8 != 0
+            || !key_column::fits(header.count, header.info_column - header.key_column)
+            || !info_column::fits(header.count, header.key_blob - header.info_column))
+            throw std::runtime_error("corrupt snapshot " + path);
+
+        n = header.count;
+        keys = base + header.key_column;
+        infos = base + header.info_column;
+        key_blob = base + header.key_blob;
+        info_blob = base + header.info_blob;
+        if (!key_column::valid(keys, n, header.info_blob - header.key_blob)
+            || !info_column::valid(infos, n, length - header.info_blob))
+            throw std::runtime_error("corrupt snapshot " + path);
+    }
+
+public:
+    static const size_t npos = static_cast<size_t>(-1);
+
+    explicit mapped_snapshot(const std::string& path) : base(nullptr), length(0) {
+#if defined(_WIN32)
+        file = INVALID_HANDLE_VALUE;
+        mapping = nullptr;
+#endif
+        map(path);
+        try {
+            check(path);
+        }
+        catch (...) {
+            unmap();
+            throw;
+        }
+    }
+
+    ~mapped_snapshot() { unmap(); }
+
+    mapped_snapshot(const mapped_snapshot&) = delete;
+    mapped_snapshot& operator=(const mapped_snapshot&) = delete;
+
+    size_t size() const { return static_cast<size_t>(n); }
+    bool isEmpty() const { return n == 0; }
+
+    Key key(size_t i) const { return key_column::get(keys, key_blob, i); }
+    Info info(size_t i) const { return info_column::get(infos, info_blob, i); }
+
+    //index of the first key not less than key, size() if there is none
+    size_t lower_bound(const Key& key) const {
+        size_t lo = 0, hi = static_cast<size_t>(n);
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (key_column::less(keys, key_blob, mid, key))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+    //index of key, npos when it is missing
+    size_t index_of(const Key& key) const {
+        size_t i = lower_bound(key);
+        if (i < n && key_column::equal(keys, key_blob, i, key))
+            return i;
+        return npos;
+    }
+
+    bool search(const Key& key) const {
+        return index_of(key) != npos;
+    }
+
+    //copies the info of key into out; false when key is missing
+    bool get(const Key& key, Info& out) const {
+        size_t i = index_of(key);
+        if (i == npos)
+            return false;
+        out = info(i);
+        return true;
+    }
+};
+
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+class avltree;
+template <typename key, typename val, typename storage>
+class Dictionary;
+
+//writes a snapshot of tree that mapped_snapshot<Key, Info> opens
+template <typename Key, typename Info, template <typename> class Allocator, typename Stats, typename MaxInfo>
+void save(const avltree<Key, Info, Allocator, Stats, MaxInfo>& tree, const std::string& path) {
+    snapshot_writer<Key, Info> writer;
+    for (auto it = tree.begin(); it != tree.end(); ++it)
+        writer.add(it.key(), it.info());
+    writer.write(path);
+}
+
+//the same for a Dictionary; unordered storages are sorted by key first
+template <typename key, typename val, typename storage>
+void save(const Dictionary<key, val, storage>& dict, const std::string& path) {
+    snapshot_writer<key, val> writer;
+    if (storage::ordered) {
+        for (auto it = dict.constBegin(); it != dict.constEnd(); ++it)
+            writer.add(it.getKey(), it.getVal());
+    }
+    else {
+        std::vector<std::pair<const key*, const val*>> entries;
+        for (auto it = dict.constBegin(); it != dict.constEnd(); ++it)
+            entries.push_back(std::make_pair(&it.getKey(), &it.getVal()));
+        std::sort(entries.begin(), entries.end(), [](const std::pair<const key*, const val*>& a, const std::pair<const key*, const val*>& b) {
+            return *a.first < *b.first;
+        });
+        for (const auto& entry : entries)
+            writer.add(*entry.first, *entry.second);
+    }
+    writer.write(path);
+}
+
+#endif
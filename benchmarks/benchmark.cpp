@@ -0,0 +1,889 @@
+// benchmark.cpp : times the containers of My_algo against the standard library.
+//
+// usage: benchmark [--n=N] [--list-n=N] [--ring-n=N] [--queries=N] [--corpus=N] [--skew=S] [--seed=N]
+//                  [--threads=N] [--filter=TEXT] [--format=csv|json] [--out=FILE]
+//
+// --n        distinct keys for the tree and hash based maps
+// --list-n   distinct keys for the containers with linear inserts (Linked_List)
+// --ring-n   elements of the sequence benchmarks (bi_ring against std::list) and items sent
+//            through the work queues
+// --queries  lookups per find benchmark, drawn from the Zipfian word distribution
+// --corpus   words in the text counted by the word count benchmarks
+// --filter   only run rows whose suite, container or operation contains TEXT
+//
+// Every row is one timed run: suite, container, operation, n (container size), ops (operations
+// timed), seconds and ns per operation. CSV is the default; JSON writes the same rows as an array.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "array_ring.h"
+#include "avl_tree.h"
+#include "bi_ring.h"
+#include "Concurrent_Dictionary.h"
+#include "Dictionary.h"
+#include "ring_queue.h"
+#include "zipf_corpus.h"
+
+namespace {
+
+struct Options {
+    size_t n = 20000;
+    size_t list_n = 4000;
+    size_t ring_n = 1000000;
+    size_t queries = 200000;
+    size_t corpus = 1000000;
+    double skew = 1.0;
+    uint32_t seed = 42;
+    unsigned threads = 0;
+    std::string filter;
+    std::string format = "csv";
+    std::string out;
+};
+
+struct Row {
+    std::string suite, container, operation;
+    size_t n, ops;
+    double seconds;
+};
+
+//results accumulate here, so the optimizer can't drop the timed work
+volatile size_t sink;
+
+class Bench {
+private:
+    const Options& opts;
+    std::vector<Row> rows;
+    std::string suite;
+
+    bool wanted(const std::string& container, const std::string& operation) const {
+        if (opts.filter.empty())
+            return true;
+        for (const std::string* s : { &suite, &container, &operation })
+            if (s->find(opts.filter) != std::string::npos)
+                return true;
+        return false;
+    }
+
+public:
+    explicit Bench(const Options& o) : opts(o) {}
+
+    void begin_suite(const std::string& name) { suite = name; }
+
+    //times f once; f returns a value that goes to the sink
+    template <typename F>
+    void run(const std::string& container, const std::string& operation, size_t n, size_t ops, F f) {
+        if (!wanted(container, operation))
+            return;
+        auto start = std::chrono::steady_clock::now();
+        sink = sink + static_cast<size_t>(f());
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        rows.push_back(Row{ suite, container, operation, n, ops, s });
+        std::cerr << suite << ' ' << container << ' ' << operation << ": " << s << " s" << std::endl;
+    }
+
+    void write(std::ostream& os) const {
+        if (opts.format == "json") {
+            os << "[\n";
+            for (size_t i = 0; i < rows.size(); i++) {
+                const Row& r = rows[i];
+                os << "  {\"suite\": \"" << r.suite << "\", \"container\": \"" << r.container
+                    << "\", \"operation\": \"" << r.operation << "\", \"n\": " << r.n << ", \"ops\": " << r.ops
+                    << ", \"seconds\": " << r.seconds << ", \"ns_per_op\": " << r.seconds * 1e9 / (r.ops ? r.ops : 1)
+                    << (i + 1 < rows.size() ? "},\n" : "}\n");
+            }
+            os << "]\n";
+        }
+        else {
+            os << "suite,container,operation,n,ops,seconds,ns_per_op\n";
+            for (const Row& r : rows)
+                os << r.suite << ',' << r.container << ',' << r.operation << ',' << r.n << ',' << r.ops << ','
+                    << r.seconds << ',' << r.seconds * 1e9 / (r.ops ? r.ops : 1) << '\n';
+        }
+    }
+};
+
+//*************** ordered and hashed maps with string keys ***************//
+
+//the common insert/find/iterate/erase/join/merge run for std::map and std::unordered_map
+template <typename Map>
+void std_map_suite(Bench& b, const std::string& name, const std::vector<std::string>& keys,
+    const std::vector<std::string>& queries, const std::vector<std::string>& tokens) {
+    size_t n = keys.size();
+    Map m;
+    b.run(name, "insert", n, n, [&]() {
+        for (size_t i = 0; i < n; i++)
+            m.emplace(keys[i], static_cast<int>(i));
+        return m.size();
+    });
+    b.run(name, "find", n, queries.size(), [&]() {
+        size_t hits = 0;
+        for (const auto& q : queries)
+            hits += m.find(q) != m.end();
+        return hits;
+    });
+    b.run(name, "iterate", n, n, [&]() {
+        size_t sum = 0;
+        for (const auto& e : m)
+            sum += e.second;
+        return sum;
+    });
+    Map left(m.begin(), m.end());
+    b.run(name, "erase", n, n, [&]() {
+        for (const auto& k : keys)
+            m.erase(k);
+        return m.size();
+    });
+
+    Map right;
+    for (size_t i = n / 2; i < n; i++)
+        right.emplace(keys[i], 1);
+    b.run(name, "join", n, right.size(), [&]() {
+        for (const auto& e : right)
+            left[e.first] += e.second;
+        return left.size();
+    });
+    Map counts;
+    b.run(name, "merge", n, tokens.size(), [&]() {
+        for (const auto& t : tokens)
+            counts[t]++;
+        return counts.size();
+    });
+}
+
+template <template <typename> class Allocator>
+void avltree_suite(Bench& b, const std::string& name, const std::vector<std::string>& keys,
+    const std::vector<std::string>& queries, const std::vector<std::string>& tokens) {
+    size_t n = keys.size();
+    avltree<std::string, int, Allocator> t;
+    b.run(name, "insert", n, n, [&]() {
+        for (size_t i = 0; i < n; i++)
+            t.insert(keys[i], static_cast<int>(i));
+        return t.isEmpty();
+    });
+    b.run(name, "find", n, queries.size(), [&]() {
+        size_t hits = 0;
+        for (const auto& q : queries)
+            hits += t.search(q);
+        return hits;
+    });
+    b.run(name, "iterate", n, n, [&]() {
+        size_t sum = 0;
+        for (auto it = t.begin(); it != t.end(); ++it)
+            sum += it.info();
+        return sum;
+    });
+    avltree<std::string, int, Allocator> left = t;
+    b.run(name, "erase", n, n, [&]() {
+        for (const auto& k : keys)
+            t.deleteNode(k);
+        return t.isEmpty();
+    });
+
+    avltree<std::string, int, Allocator> right;
+    for (size_t i = n / 2; i < n; i++)
+        right.insert(keys[i], 1);
+    b.run(name, "join", n, n - n / 2, [&]() {
+        left.set_union(right);
+        return left.isEmpty();
+    });
+    avltree<std::string, int, Allocator> counts;
+    b.run(name, "merge", n, tokens.size(), [&]() {
+        for (const auto& w : tokens)
+            counts.increment(w, 1);
+        return counts.isEmpty();
+    });
+}
+
+//Dictionary over any storage; it has no erase of its own
+template <typename Storage>
+void dictionary_suite(Bench& b, const std::string& name, const std::vector<std::string>& keys,
+    const std::vector<std::string>& queries, const std::vector<std::string>& tokens) {
+    typedef Dictionary<std::string, int, Storage> Dict;
+    size_t n = keys.size();
+    Dict d;
+    b.run(name, "insert", n, n, [&]() {
+        for (size_t i = 0; i < n; i++)
+            d.insert(keys[i], static_cast<int>(i));
+        return d.getSize();
+    });
+    std::vector<std::pair<std::string, int>> batch;
+    for (size_t i = 0; i < n; i++)
+        batch.push_back(std::make_pair(keys[i], static_cast<int>(i)));
+    Dict loaded;
+    b.run(name, "insert_batch", n, n, [&]() {
+        loaded.insert_batch(batch.begin(), batch.end());
+        return loaded.getSize();
+    });
+    b.run(name, "find", n, queries.size(), [&]() {
+        size_t hits = 0;
+        for (const auto& q : queries)
+            hits += d.get(q) != nullptr;
+        return hits;
+    });
+    b.run(name, "find_many", n, queries.size(), [&]() {
+        size_t hits = 0;
+        for (int* v : d.find_many(queries.begin(), queries.end()))
+            hits += v != nullptr;
+        return hits;
+    });
+    b.run(name, "iterate", n, n, [&]() {
+        size_t sum = 0;
+        for (auto it = d.constBegin(); it != d.constEnd(); ++it)
+            sum += it.getVal();
+        return sum;
+    });
+
+    Dict left, right;
+    for (size_t i = 0; i < n; i++)
+        (i < n / 2 ? left : right).insert(keys[i], 1);
+    b.run(name, "join", n, n, [&]() {
+        return join(left, right).getSize();
+    });
+    Dict counts;
+    b.run(name, "merge", n, tokens.size(), [&]() {
+        for (const auto& t : tokens) {
+            int* v = counts.get(t);
+            if (v)
+                ++*v;
+            else
+                counts.insert(t, 1);
+        }
+        return counts.getSize();
+    });
+}
+
+void linked_list_suite(Bench& b, const std::vector<std::string>& keys, const std::vector<std::string>& queries) {
+    size_t n = keys.size();
+    Linked_List<std::string, int> l;
+    b.run("Linked_List", "insert", n, n, [&]() {
+        for (size_t i = 0; i < n; i++)
+            l.insert(keys[i], static_cast<int>(i));
+        return l.getSize();
+    });
+    std::vector<std::pair<std::string, int>> batch;
+    for (size_t i = 0; i < n; i++)
+        batch.push_back(std::make_pair(keys[i], static_cast<int>(i)));
+    Linked_List<std::string, int> loaded;
+    b.run("Linked_List", "insert_batch", n, n, [&]() {
+        loaded.insert_batch(batch.begin(), batch.end());
+        return loaded.getSize();
+    });
+    b.run("Linked_List", "find", n, queries.size(), [&]() {
+        size_t hits = 0;
+        for (const auto& q : queries)
+            hits += l.find(q);
+        return hits;
+    });
+    b.run("Linked_List", "find_many", n, queries.size(), [&]() {
+        size_t hits = 0;
+        for (int* v : l.find_many(queries.begin(), queries.end()))
+            hits += v != nullptr;
+        return hits;
+    });
+    b.run("Linked_List", "iterate", n, n, [&]() {
+        size_t sum = 0;
+        for (auto it = l.constBegin(); it != l.constEnd(); ++it)
+            sum += it.getVal();
+        return sum;
+    });
+}
+
+//*************** integer keys ***************//
+
+template <typename Map>
+void int_std_suite(Bench& b, const std::string& name, const std::vector<int>& keys, const std::vector<int>& queries) {
+    Map m;
+    b.run(name, "insert", keys.size(), keys.size(), [&]() {
+        for (int k : keys)
+            m.emplace(k, k);
+        return m.size();
+    });
+    b.run(name, "find", keys.size(), queries.size(), [&]() {
+        size_t hits = 0;
+        for (int q : queries)
+            hits += m.find(q) != m.end();
+        return hits;
+    });
+    b.run(name, "erase", keys.size(), keys.size(), [&]() {
+        for (int k : keys)
+            m.erase(k);
+        return m.size();
+    });
+}
+
+template <typename Storage>
+void int_dictionary_suite(Bench& b, const std::string& name, const std::vector<int>& keys, const std::vector<int>& queries) {
+    Dictionary<int, int, Storage> d;
+    b.run(name, "insert", keys.size(), keys.size(), [&]() {
+        for (int k : keys)
+            d.insert(k, k);
+        return d.getSize();
+    });
+    b.run(name, "find", keys.size(), queries.size(), [&]() {
+        size_t hits = 0;
+        for (int q : queries)
+            hits += d.get(q) != nullptr;
+        return hits;
+    });
+    //copies go through the storage's copy(); join of a dictionary with its copy keeps every key once
+    typedef Dictionary<int, int, Storage> Dict;
+    Dict copy(d);
+    Dict assigned;
+    b.run(name, "copy", keys.size(), 2 * keys.size(), [&]() {
+        copy = Dict(d);
+        assigned = copy;
+        return assigned.getSize();
+    });
+    b.run(name, "join", keys.size(), 2 * keys.size(), [&]() {
+        Dict joined = join(d, assigned);
+        if (joined.getSize() != d.getSize())
+            throw std::runtime_error(name + ": join of a dictionary with its copy changed the key count");
+        return joined.getSize();
+    });
+}
+
+void int_avltree_suite(Bench& b, const std::vector<int>& keys, const std::vector<int>& queries) {
+    avltree<int, int> t;
+    b.run("avltree", "insert", keys.size(), keys.size(), [&]() {
+        for (int k : keys)
+            t.insert(k, k);
+        return t.isEmpty();
+    });
+    b.run("avltree", "find", keys.size(), queries.size(), [&]() {
+        size_t hits = 0;
+        for (int q : queries)
+            hits += t.search(q);
+        return hits;
+    });
+    frozen_avltree<int, int> frozen = t.freeze();
+    b.run("frozen_avltree", "find", keys.size(), queries.size(), [&]() {
+        size_t hits = 0;
+        for (int q : queries)
+            hits += frozen.find(q) != nullptr;
+        return hits;
+    });
+    b.run("frozen_avltree", "find_many", keys.size(), queries.size(), [&]() {
+        size_t hits = 0;
+        for (const int* v : frozen.find_many(queries))
+            hits += v != nullptr;
+        return hits;
+    });
+    b.run("avltree", "erase", keys.size(), keys.size(), [&]() {
+        for (int k : keys)
+            t.deleteNode(k);
+        return t.isEmpty();
+    });
+}
+
+//*************** sequences ***************//
+
+void sequence_suite(Bench& b, size_t n, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<int> infos(n);
+    for (auto& i : infos)
+        i = static_cast<int>(rng() % 1000000);
+
+    bi_ring<int, int> ring;
+    array_ring<int, int> array;
+    std::list<std::pair<int, int>> list;
+    b.run("bi_ring", "insert", n, n, [&]() {
+        for (size_t i = 0; i < n; i++)
+            ring.push_back(static_cast<int>(i), infos[i]);
+        return ring.get_size();
+    });
+    b.run("array_ring", "insert", n, n, [&]() {
+        for (size_t i = 0; i < n; i++)
+            array.push_back(static_cast<int>(i), infos[i]);
+        return array.get_size();
+    });
+    b.run("std::list", "insert", n, n, [&]() {
+        for (size_t i = 0; i < n; i++)
+            list.emplace_back(static_cast<int>(i), infos[i]);
+        return list.size();
+    });
+    b.run("bi_ring", "iterate", n, n, [&]() {
+        size_t sum = 0;
+        auto it = ring.begin();
+        do {
+            sum += it.info();
+            ++it;
+        } while (it != ring.begin());
+        return sum;
+    });
+    b.run("array_ring", "iterate", n, n, [&]() {
+        size_t sum = 0;
+        auto it = array.begin();
+        do {
+            sum += it.info();
+            ++it;
+        } while (it != array.begin());
+        return sum;
+    });
+    b.run("std::list", "iterate", n, n, [&]() {
+        size_t sum = 0;
+        for (const auto& e : list)
+            sum += e.second;
+        return sum;
+    });
+
+    //both sorts relink nodes; sorting by key afterwards restores insertion order
+    auto by_info = [](const std::pair<int, int>& a, const std::pair<int, int>& c) { return a.second < c.second; };
+    auto by_key = [](const std::pair<int, int>& a, const std::pair<int, int>& c) { return a.first < c.first; };
+    b.run("bi_ring", "sort", n, n, [&]() {
+        return ring.sortByInfo();
+    });
+    b.run("std::list", "sort", n, n, [&]() {
+        list.sort(by_info);
+        return list.size();
+    });
+    b.run("bi_ring", "sort_key", n, n, [&]() {
+        return ring.sortByKey();
+    });
+    b.run("std::list", "sort_key", n, n, [&]() {
+        list.sort(by_key);
+        return list.size();
+    });
+
+    size_t part_n = n / 4;
+    bi_ring<int, int> part;
+    std::list<std::pair<int, int>> part_list;
+    for (size_t i = 0; i < part_n; i++) {
+        part.push_back(static_cast<int>(i), infos[i]);
+        part_list.emplace_back(static_cast<int>(i), infos[i]);
+    }
+    part.sortByInfo();
+    part_list.sort(by_info);
+    //merge moves the nodes of sorted rings like std::list::merge; merge_copy copies and sorts first
+    std::vector<bi_ring<int, int>> parts(4, part);
+    b.run("bi_ring", "merge_copy", 4 * part_n, 4 * part_n, [&]() {
+        return merge(parts).get_size();
+    });
+    std::vector<bi_ring<int, int>> moved_parts(parts);
+    b.run("bi_ring", "merge", 4 * part_n, 4 * part_n, [&]() {
+        return merge(std::move(moved_parts), true).get_size();
+    });
+    b.run("bi_ring", "merge_parallel", 4 * part_n, 4 * part_n, [&]() {
+        return merge(std::move(parts), true, true).get_size();
+    });
+    std::vector<std::list<std::pair<int, int>>> list_parts(4, part_list);
+    b.run("std::list", "merge", 4 * part_n, 4 * part_n, [&]() {
+        std::list<std::pair<int, int>> out;
+        for (auto& p : list_parts)
+            out.merge(p, by_info);
+        return out.size();
+    });
+
+    //moves the ring to another one in chunks of 64 and back in one piece; only links change
+    const size_t chunk = 64;
+    b.run("bi_ring", "splice", n, n / chunk + 1, [&]() {
+        bi_ring<int, int> other;
+        while (static_cast<size_t>(ring.get_size()) >= chunk) {
+            auto last = ring.begin();
+            for (size_t j = 0; j < chunk; j++)
+                ++last;
+            other.splice(other.begin(), ring, ring.begin(), last);
+        }
+        ring.append(other);
+        return ring.get_size();
+    });
+    b.run("std::list", "splice", n, n / chunk + 1, [&]() {
+        std::list<std::pair<int, int>> other;
+        while (list.size() >= chunk)
+            other.splice(other.begin(), list, list.begin(), std::next(list.begin(), chunk));
+        list.splice(list.end(), other);
+        return list.size();
+    });
+
+    b.run("bi_ring", "erase", n, n, [&]() {
+        while (!ring.empty())
+            ring.pop_front();
+        return ring.get_size();
+    });
+    b.run("array_ring", "erase", n, n, [&]() {
+        while (!array.empty())
+            array.pop_front();
+        return array.get_size();
+    });
+    b.run("std::list", "erase", n, n, [&]() {
+        while (!list.empty())
+            list.pop_front();
+        return list.size();
+    });
+
+    //FIFO use of the ends only: a window of 1024 elements slides over n pushes
+    const size_t window = 1024;
+    b.run("bi_ring", "queue", n, 2 * n, [&]() {
+        for (size_t i = 0; i < n; i++) {
+            ring.push_back(static_cast<int>(i), infos[i]);
+            if (i >= window)
+                ring.pop_front();
+        }
+        size_t left = ring.get_size();
+        ring.clear();
+        return left;
+    });
+    b.run("array_ring", "queue", n, 2 * n, [&]() {
+        for (size_t i = 0; i < n; i++) {
+            array.push_back(static_cast<int>(i), infos[i]);
+            if (i >= window)
+                array.pop_front();
+        }
+        size_t left = array.get_size();
+        array.clear();
+        return left;
+    });
+    b.run("std::deque", "queue", n, 2 * n, [&]() {
+        std::deque<std::pair<int, int>> deque;
+        for (size_t i = 0; i < n; i++) {
+            deque.emplace_back(static_cast<int>(i), infos[i]);
+            if (i >= window)
+                deque.pop_front();
+        }
+        return deque.size();
+    });
+}
+
+//*************** word counting ***************//
+
+void word_count_suite(Bench& b, const std::string& text, size_t words, unsigned threads) {
+    b.run("count_words", "merge", words, words, [&]() {
+        std::istringstream is(text);
+        return count_words<std::string, int>(is).isEmpty();
+    });
+    b.run("count_words_pool", "merge", words, words, [&]() {
+        std::istringstream is(text);
+        return count_words<std::string, int, pool_allocator>(is).isEmpty();
+    });
+    b.run("std::unordered_map", "merge", words, words, [&]() {
+        std::istringstream is(text);
+        std::unordered_map<std::string, int> counts;
+        std::string w;
+        while (is >> w)
+            counts[w]++;
+        return counts.size();
+    });
+
+    //the parallel counter at growing thread counts, to see how it scales
+    for (unsigned t = 1; t <= threads; t *= 2) {
+        b.run("count_words_parallel", std::to_string(t) + "_threads", words, words, [&]() {
+            std::istringstream is(text);
+            return count_words_parallel<std::string, int>(is, t).isEmpty();
+        });
+    }
+}
+
+//*************** concurrent access ***************//
+
+//every thread does 90% lookups and 10% assignments on keys from a shared range
+void concurrent_suite(Bench& b, size_t n, size_t ops_per_thread, unsigned threads, uint32_t seed) {
+    std::vector<int> keys(ops_per_thread);
+    std::mt19937 rng(seed);
+    for (auto& k : keys)
+        k = static_cast<int>(rng() % n);
+    std::string name = std::to_string(threads) + "_threads";
+
+    Concurrent_Dictionary<int, int> cd;
+    for (size_t i = 0; i < n; i++)
+        cd.insert(static_cast<int>(i), 0);
+    b.run("Concurrent_Dictionary", name, n, ops_per_thread * threads, [&]() {
+        std::vector<std::thread> workers;
+        std::vector<size_t> hits(threads);
+        for (unsigned t = 0; t < threads; t++) {
+            workers.push_back(std::thread([&, t]() {
+                int v;
+                for (size_t i = 0; i < keys.size(); i++) {
+                    int k = keys[(i + t * 7919) % keys.size()];
+                    if (i % 10 == 0)
+                        cd.assign(k, static_cast<int>(i));
+                    else
+                        hits[t] += cd.get(k, v);
+                }
+            }));
+        }
+        for (auto& w : workers)
+            w.join();
+        return std::accumulate(hits.begin(), hits.end(), size_t(0));
+    });
+
+    std::unordered_map<int, int> um;
+    std::mutex lock;
+    for (size_t i = 0; i < n; i++)
+        um.emplace(static_cast<int>(i), 0);
+    b.run("std::unordered_map+mutex", name, n, ops_per_thread * threads, [&]() {
+        std::vector<std::thread> workers;
+        std::vector<size_t> hits(threads);
+        for (unsigned t = 0; t < threads; t++) {
+            workers.push_back(std::thread([&, t]() {
+                for (size_t i = 0; i < keys.size(); i++) {
+                    int k = keys[(i + t * 7919) % keys.size()];
+                    std::lock_guard<std::mutex> guard(lock);
+                    if (i % 10 == 0)
+                        um[k] = static_cast<int>(i);
+                    else
+                        hits[t] += um.count(k);
+                }
+            }));
+        }
+        for (auto& w : workers)
+            w.join();
+        return std::accumulate(hits.begin(), hits.end(), size_t(0));
+    });
+}
+
+//*************** work queues ***************//
+
+//pairs producers send items through a queue to pairs consumers, which stop once all arrived.
+//push(i, end) offers items [i, end) and pop(sum) takes some, adding up their infos; both try once
+//and return how many items they moved. Item i carries info i, so the count and the sum of the infos
+//consumed show whether the queue lost or duplicated any; a mismatch throws. Returns the sum
+template <typename Push, typename Pop>
+size_t pipeline(size_t items, unsigned pairs, Push push, Pop pop) {
+    std::atomic<size_t> consumed(0);
+    std::vector<size_t> sums(pairs);
+    std::vector<std::thread> workers;
+    for (unsigned p = 0; p < pairs; p++) {
+        workers.push_back(std::thread([&, p]() {
+            size_t i = items * p / pairs;
+            const size_t end = items * (p + 1) / pairs;
+            while (i < end) {
+                size_t n = push(i, end);
+                if (n == 0)
+                    std::this_thread::yield();
+                i += n;
+            }
+        }));
+        workers.push_back(std::thread([&, p]() {
+            size_t sum = 0;
+            while (consumed.load(std::memory_order_relaxed) < items) {
+                size_t n = pop(sum);
+                if (n == 0)
+                    std::this_thread::yield();
+                consumed += n;
+            }
+            sums[p] = sum;
+        }));
+    }
+    for (auto& w : workers)
+        w.join();
+    size_t sum = std::accumulate(sums.begin(), sums.end(), size_t(0));
+    if (consumed.load() != items || sum != items * (items - 1) / 2)
+        throw std::runtime_error("pipeline: items consumed do not match the items produced");
+    return sum;
+}
+
+//mutex guarded bi_ring against the lock-free rings, one item or up to BATCH items per call
+void queue_suite(Bench& b, size_t items, unsigned pairs) {
+    const size_t capacity = 1024;
+    const size_t BATCH = 64;
+    std::string name = std::to_string(pairs) + "_pairs";
+    typedef std::pair<int, int> item;
+
+    bi_ring<int, int> ring;
+    std::mutex lock;
+    b.run("bi_ring+mutex", name, capacity, items, [&]() {
+        return pipeline(items, pairs, [&](size_t i, size_t) -> size_t {
+            std::lock_guard<std::mutex> guard(lock);
+            if (static_cast<size_t>(ring.get_size()) >= capacity)
+                return 0;
+            ring.push_back(static_cast<int>(i), static_cast<int>(i));
+            return 1;
+        }, [&](size_t& sum) -> size_t {
+            std::lock_guard<std::mutex> guard(lock);
+            if (ring.empty())
+                return 0;
+            sum += ring.begin().info();
+            ring.pop_front();
+            return 1;
+        });
+    });
+
+    mpmc_ring<int, int> mpmc(capacity);
+    b.run("mpmc_ring", name, capacity, items, [&]() {
+        return pipeline(items, pairs, [&](size_t i, size_t) -> size_t {
+            return mpmc.try_push(static_cast<int>(i), static_cast<int>(i)) ? 1 : 0;
+        }, [&](size_t& sum) -> size_t {
+            int k, v;
+            if (!mpmc.try_pop(k, v))
+                return 0;
+            sum += v;
+            return 1;
+        });
+    });
+    b.run("mpmc_ring_batch", name, capacity, items, [&]() {
+        return pipeline(items, pairs, [&](size_t i, size_t end) {
+            item batch[BATCH];
+            size_t n = std::min(BATCH, end - i);
+            for (size_t j = 0; j < n; j++)
+                batch[j] = item(static_cast<int>(i + j), static_cast<int>(i + j));
+            return mpmc.try_push_batch(batch, batch + n);
+        }, [&](size_t& sum) {
+            item batch[BATCH];
+            size_t n = mpmc.try_pop_batch(batch, BATCH);
+            for (size_t j = 0; j < n; j++)
+                sum += batch[j].second;
+            return n;
+        });
+    });
+
+    if (pairs != 1)
+        return;
+    spsc_ring<int, int> spsc(capacity);
+    b.run("spsc_ring", name, capacity, items, [&]() {
+        return pipeline(items, pairs, [&](size_t i, size_t) -> size_t {
+            return spsc.try_push(static_cast<int>(i), static_cast<int>(i)) ? 1 : 0;
+        }, [&](size_t& sum) -> size_t {
+            int k, v;
+            if (!spsc.try_pop(k, v))
+                return 0;
+            sum += v;
+            return 1;
+        });
+    });
+    b.run("spsc_ring_batch", name, capacity, items, [&]() {
+        return pipeline(items, pairs, [&](size_t i, size_t end) {
+            item batch[BATCH];
+            size_t n = std::min(BATCH, end - i);
+            for (size_t j = 0; j < n; j++)
+                batch[j] = item(static_cast<int>(i + j), static_cast<int>(i + j));
+            return spsc.try_push_batch(batch, batch + n);
+        }, [&](size_t& sum) {
+            item batch[BATCH];
+            size_t n = spsc.try_pop_batch(batch, BATCH);
+            for (size_t j = 0; j < n; j++)
+                sum += batch[j].second;
+            return n;
+        });
+    });
+}
+
+bool parse(int argc, char** argv, Options& opts) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string name = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (name == "--n")
+            opts.n = std::stoul(value);
+        else if (name == "--list-n")
+            opts.list_n = std::stoul(value);
+        else if (name == "--ring-n")
+            opts.ring_n = std::stoul(value);
+        else if (name == "--queries")
+            opts.queries = std::stoul(value);
+        else if (name == "--corpus")
+            opts.corpus = std::stoul(value);
+        else if (name == "--skew")
+            opts.skew = std::stod(value);
+        else if (name == "--seed")
+            opts.seed = static_cast<uint32_t>(std::stoul(value));
+        else if (name == "--threads")
+            opts.threads = static_cast<unsigned>(std::stoul(value));
+        else if (name == "--filter")
+            opts.filter = value;
+        else if (name == "--format" && (value == "csv" || value == "json"))
+            opts.format = value;
+        else if (name == "--out")
+            opts.out = value;
+        else {
+            std::cerr << "unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+} //namespace
+
+int main(int argc, char** argv) {
+    Options opts;
+    if (!parse(argc, argv, opts))
+        return 1;
+    if (opts.threads == 0)
+        opts.threads = std::max(1u, std::thread::hardware_concurrency());
+    if (opts.list_n > opts.n)
+        opts.list_n = opts.n;
+
+    zipf_corpus corpus(opts.n, opts.skew, opts.seed);
+    std::mt19937 rng(opts.seed);
+
+    //inserts go in random order, lookups follow the word frequencies
+    std::vector<std::string> keys = corpus.words();
+    std::shuffle(keys.begin(), keys.end(), rng);
+    std::vector<std::string> list_keys(keys.begin(), keys.begin() + opts.list_n);
+    std::vector<std::string> queries = corpus.tokens(opts.queries, opts.seed + 1);
+    std::vector<std::string> list_queries(queries.begin(), queries.begin() + std::min(queries.size(), opts.list_n));
+    std::vector<std::string> tokens = corpus.tokens(opts.corpus, opts.seed + 2);
+    std::vector<std::string> list_tokens(tokens.begin(), tokens.begin() + std::min(tokens.size(), 10 * opts.list_n));
+
+    std::vector<int> int_keys(opts.n);
+    std::iota(int_keys.begin(), int_keys.end(), 0);
+    std::shuffle(int_keys.begin(), int_keys.end(), rng);
+    std::vector<int> int_queries;
+    for (size_t k : corpus.ranks(opts.queries, opts.seed + 3))
+        int_queries.push_back(static_cast<int>(k));
+
+    Bench b(opts);
+
+    b.begin_suite("string_map");
+    std_map_suite<std::map<std::string, int>>(b, "std::map", keys, queries, tokens);
+    std_map_suite<std::unordered_map<std::string, int>>(b, "std::unordered_map", keys, queries, tokens);
+    avltree_suite<heap_allocator>(b, "avltree", keys, queries, tokens);
+    avltree_suite<pool_allocator>(b, "avltree_pool", keys, queries, tokens);
+    dictionary_suite<Skip_List<std::string, int>>(b, "Dictionary<Skip_List>", keys, queries, tokens);
+    dictionary_suite<Hash_Table<std::string, int>>(b, "Dictionary<Hash_Table>", keys, queries, tokens);
+
+    b.begin_suite("string_list");
+    dictionary_suite<Linked_List<std::string, int>>(b, "Dictionary<Linked_List>", list_keys, list_queries, list_tokens);
+    dictionary_suite<Unrolled_List<std::string, int>>(b, "Dictionary<Unrolled_List>", list_keys, list_queries, list_tokens);
+    linked_list_suite(b, list_keys, list_queries);
+
+    b.begin_suite("int_map");
+    int_std_suite<std::map<int, int>>(b, "std::map", int_keys, int_queries);
+    int_std_suite<std::unordered_map<int, int>>(b, "std::unordered_map", int_keys, int_queries);
+    int_avltree_suite(b, int_keys, int_queries);
+    int_dictionary_suite<Flat_List<int, int>>(b, "Dictionary<Flat_List>", int_keys, int_queries);
+    int_dictionary_suite<Hash_Table<int, int>>(b, "Dictionary<Hash_Table>", int_keys, int_queries);
+
+    b.begin_suite("sequence");
+    sequence_suite(b, opts.ring_n, opts.seed);
+
+    b.begin_suite("word_count");
+    std::string text = corpus.text(opts.corpus, opts.seed + 4);
+    word_count_suite(b, text, opts.corpus, opts.threads);
+
+    b.begin_suite("concurrent");
+    for (unsigned t = 1; t <= opts.threads; t *= 2)
+        concurrent_suite(b, opts.n, opts.queries, t, opts.seed);
+
+    b.begin_suite("queue");
+    for (unsigned t = 1; t <= opts.threads; t *= 2)
+        queue_suite(b, opts.ring_n, t);
+
+    if (opts.out.empty())
+        b.write(std::cout);
+    else {
+        std::ofstream out(opts.out);
+        b.write(out);
+    }
+    return 0;
+}
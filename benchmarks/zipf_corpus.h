@@ -0,0 +1,84 @@
+#ifndef ZIPF_CORPUS_H
+#define ZIPF_CORPUS_H
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+//Synthetic word corpus for the benchmarks.
+//The vocabulary is a set of distinct random lowercase words; word k (0-based rank) is
+//drawn with probability proportional to 1 / (k + 1)^skew, which is roughly how word
+//frequencies in natural text behave (skew = 1 is classic Zipf).
+class zipf_corpus {
+private:
+    std::vector<std::string> vocabulary;
+    std::vector<double> cdf; //cdf[k] = P(rank <= k)
+
+public:
+    zipf_corpus(size_t words, double skew, uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<int> length(2, 12);
+        std::uniform_int_distribution<int> letter('a', 'z');
+        std::unordered_set<std::string> seen;
+        while (vocabulary.size() < words) {
+            std::string w(length(rng), ' ');
+            for (auto& c : w)
+                c = static_cast<char>(letter(rng));
+            if (seen.insert(w).second)
+                vocabulary.push_back(w);
+        }
+
+        cdf.resize(words);
+        double sum = 0;
+        for (size_t k = 0; k < words; k++) {
+            sum += 1.0 / std::pow(static_cast<double>(k + 1), skew);
+            cdf[k] = sum;
+        }
+        for (auto& c : cdf)
+            c /= sum;
+    }
+
+    //distinct words, most frequent first
+    const std::vector<std::string>& words() const { return vocabulary; }
+
+    //rank of a random word
+    template <typename Rng>
+    size_t sample(Rng& rng) const {
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        size_t k = std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+        return k < cdf.size() ? k : cdf.size() - 1;
+    }
+
+    std::vector<size_t> ranks(size_t count, uint32_t seed) const {
+        std::mt19937 rng(seed);
+        std::vector<size_t> out(count);
+        for (auto& k : out)
+            k = sample(rng);
+        return out;
+    }
+
+    std::vector<std::string> tokens(size_t count, uint32_t seed) const {
+        std::vector<std::string> out;
+        out.reserve(count);
+        for (size_t k : ranks(count, seed))
+            out.push_back(vocabulary[k]);
+        return out;
+    }
+
+    //tokens separated by spaces, with a newline every 16 words
+    std::string text(size_t count, uint32_t seed) const {
+        std::string out;
+        size_t i = 0;
+        for (size_t k : ranks(count, seed)) {
+            out += vocabulary[k];
+            out += ++i % 16 == 0 ? '\n' : ' ';
+        }
+        return out;
+    }
+};
+
+#endif